@@ -0,0 +1,69 @@
+// File: arena.cpp
+/*
+    Pep8-1 is a virtual machine for writing machine language and assembly
+    language programs.
+    
+    Copyright (C) 2009  J. Stanley Warford, Pepperdine University
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <QMutexLocker>
+#include <new>
+#include "arena.h"
+
+Arena::FreeBlock *Arena::freeLists[Arena::maxBlockSize / Arena::granularity];
+QList<char *> Arena::chunks;
+char *Arena::chunkCursor = 0;
+char *Arena::chunkEnd = 0;
+QMutex Arena::mutex;
+
+void *Arena::allocate(size_t size)
+{
+    if (size == 0 || size > maxBlockSize) {
+        return ::operator new(size);
+    }
+    size_t sizeClass = (size - 1) / granularity;
+    QMutexLocker locker(&mutex);
+    FreeBlock *block = freeLists[sizeClass];
+    if (block != 0) {
+        freeLists[sizeClass] = block->next;
+        return block;
+    }
+    size_t blockSize = (sizeClass + 1) * granularity;
+    if (chunkCursor == 0 || static_cast<size_t>(chunkEnd - chunkCursor) < blockSize) {
+        chunkCursor = static_cast<char *>(::operator new(chunkSize));
+        chunkEnd = chunkCursor + chunkSize;
+        chunks.append(chunkCursor);
+    }
+    void *result = chunkCursor;
+    chunkCursor += blockSize;
+    return result;
+}
+
+void Arena::release(void *block, size_t size)
+{
+    if (block == 0) {
+        return;
+    }
+    if (size == 0 || size > maxBlockSize) {
+        ::operator delete(block);
+        return;
+    }
+    size_t sizeClass = (size - 1) / granularity;
+    QMutexLocker locker(&mutex);
+    FreeBlock *freeBlock = static_cast<FreeBlock *>(block);
+    freeBlock->next = freeLists[sizeClass];
+    freeLists[sizeClass] = freeBlock;
+}
@@ -0,0 +1,59 @@
+// File: arena.h
+/*
+    Pep8-1 is a virtual machine for writing machine language and assembly
+    language programs.
+    
+    Copyright (C) 2009  J. Stanley Warford, Pepperdine University
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <QList>
+#include <QMutex>
+#include <cstddef>
+
+// Allocator for the Code and Argument objects the assembler creates for every source line.
+// Blocks are carved from large chunks, and a released block goes on a free list for its size,
+// so reassembly reuses the blocks of the previous assembly instead of going to the heap.
+class Arena
+{
+public:
+    static void *allocate(size_t size);
+    // Post: Returns a block of at least size bytes.
+
+    static void release(void *block, size_t size);
+    // Pre: block was returned by allocate(size).
+    // Post: block is available to later calls of allocate with the same size class.
+
+private:
+    struct FreeBlock
+    {
+        FreeBlock *next;
+    };
+
+    static const size_t granularity = 16; // Size classes are multiples of this many bytes.
+    static const size_t maxBlockSize = 256; // Larger blocks come from the heap.
+    static const size_t chunkSize = 64 * 1024;
+
+    static FreeBlock *freeLists[maxBlockSize / granularity];
+    static QList<char *> chunks; // Chunks are never returned to the heap.
+    static char *chunkCursor;
+    static char *chunkEnd;
+    static QMutex mutex; // Lines are parsed concurrently.
+};
+
+#endif // ARENA_H
@@ -24,6 +24,7 @@
 
 #include "asm.h"
 #include "pep.h"
+#include "arena.h"
 
 // Abstract Argument class
 class Argument
@@ -31,8 +32,11 @@ class Argument
     friend class Asm;
 public:
     virtual ~Argument() { }
+    static void *operator new(size_t size) { return Arena::allocate(size); }
+    static void operator delete(void *block, size_t size) { Arena::release(block, size); }
     virtual int getArgumentValue() = 0;
     virtual QString getArgumentString() = 0;
+    virtual bool isSymbolRef() { return false; }
 };
 
 // Concrete argument classes
@@ -95,12 +99,15 @@ public:
 
 class SymbolRefArgument: public Argument
 {
+    friend class Asm;
 private:
     QString symbolRefValue;
+    int symbolId; // Index into Pep::symbols, interned by Asm::assembleSourceLines
 public:
-    SymbolRefArgument(QString sRefValue) { symbolRefValue = sRefValue; }
-    int getArgumentValue() { return Pep::symbolTable.value(symbolRefValue); }
+    SymbolRefArgument(QString sRefValue) { symbolRefValue = sRefValue; symbolId = -1; }
+    int getArgumentValue() { return Pep::symbols.at(symbolId).value; }
     QString getArgumentString() { return symbolRefValue; }
+    bool isSymbolRef() { return true; }
 };
 
 #endif // ARGUMENT_H
@@ -18,133 +18,217 @@
     You should have received a copy of the GNU General Public License
     along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
+#include <QtConcurrentMap>
+#include <QSet>
 #include "asm.h"
 #include "argument.h"
 #include "code.h"
 
-// Regular expressions for lexical analysis
-QRegExp Asm::rxAddrMode("^((,)(\\s*)(i|d|x|n|s(?![fx])|sx(?![f])|sf|sxf){1}){1}");
-QRegExp Asm::rxCharConst("^((\')(?![\'])(([^\'|\\\\]){1}|((\\\\)([\'|b|f|n|r|t|v|\"|\\\\]))|((\\\\)(([x|X])([0-9|A-F|a-f]{2}))))(\'))");
-QRegExp Asm::rxComment("^((;{1})(.)*)");
-QRegExp Asm::rxDecConst("^((([+|-]{0,1})([0-9]+))|^(([1-9])([0-9]*)))");
-QRegExp Asm::rxDotCommand("^((.)(([A-Z|a-z]{1})(\\w)*))");
-QRegExp Asm::rxHexConst("^((0(?![x|X]))|((0)([x|X])([0-9|A-F|a-f])+)|((0)([0-9]+)))");
-QRegExp Asm::rxIdentifier("^((([A-Z|a-z|_]{1})(\\w*))(:){0,1})");
-QRegExp Asm::rxStringConst("^((\")((([^\"|\\\\])|((\\\\)([\'|b|f|n|r|t|v|\"|\\\\]))|((\\\\)(([x|X])([0-9|A-F|a-f]{2}))))*)(\"))");
-
 // Regular expressions for trace tag analysis
 QRegExp Asm::rxFormatTag("(#((1c)|(1d)|(1h)|(2d)|(2h))((\\d)+a)?(\\s|$))");
 QRegExp Asm::rxSymbolTag("#([a-zA-Z][a-zA-Z0-9]{0,7})");
 QRegExp Asm::rxArrayMultiplier("((\\d)+)a");
 
-bool Asm::getToken(QString &sourceLine, ELexicalToken &token, QString &tokenString)
+// Character classes for lexical analysis
+static bool isAsciiLetter(QChar ch)
+{
+    return (ch >= 'A' && ch <= 'Z') || (ch >= 'a' && ch <= 'z');
+}
+
+static bool isHexDigit(QChar ch)
+{
+    return (ch >= '0' && ch <= '9') || (ch >= 'A' && ch <= 'F') || (ch >= 'a' && ch <= 'f');
+}
+
+static bool isWordChar(QChar ch)
+{
+    return ch.isLetterOrNumber() || ch.isMark() || ch == '_';
+}
+
+static int quotedCharLength(const QString &sourceLine, int pos, QChar quote)
+// Post: Returns the length of the possibly \ quoted character starting at pos.
+// Returns 0 if there is no character, if it is an unquoted delimiter, or if it is malformed.
+{
+    int length = sourceLine.length();
+    if (pos >= length || sourceLine[pos] == quote) {
+        return 0;
+    }
+    if (sourceLine[pos] != '\\') {
+        return 1;
+    }
+    if (pos + 1 >= length) {
+        return 0;
+    }
+    QChar ch = sourceLine[pos + 1];
+    if (ch == 'x' || ch == 'X') {
+        if (pos + 3 < length && isHexDigit(sourceLine[pos + 2]) && isHexDigit(sourceLine[pos + 3])) {
+            return 4;
+        }
+        return 0;
+    }
+    if (ch == '\'' || ch == 'b' || ch == 'f' || ch == 'n' || ch == 'r' || ch == 't' || ch == 'v' || ch == '\"' || ch == '\\') {
+        return 2;
+    }
+    return 0;
+}
+
+bool Asm::getToken(const QString &sourceLine, int &cursor, ELexicalToken &token, QString &tokenString)
 {
-    sourceLine = sourceLine.trimmed();
-    if (sourceLine.length() == 0) {
+    int length = sourceLine.length();
+    while (cursor < length && sourceLine[cursor].isSpace()) {
+        cursor++;
+    }
+    if (cursor >= length) {
         token = LT_EMPTY;
         tokenString = "";
         return true;
     }
-    QChar firstChar = sourceLine[0];
-    rxAddrMode.setCaseSensitivity (Qt::CaseInsensitive);  // Make rxAddrMode not case sensitive
+    int start = cursor;
+    int pos = cursor;
+    QChar firstChar = sourceLine[start];
     if (firstChar == ',') {
-        if (rxAddrMode.indexIn(sourceLine) == -1) {
+        pos++;
+        while (pos < length && sourceLine[pos].isSpace()) {
+            pos++;
+        }
+        QChar ch = pos < length ? sourceLine[pos].toLower() : QChar(' ');
+        if (ch == 'i' || ch == 'd' || ch == 'x' || ch == 'n') {
+            pos++;
+        }
+        else if (ch == 's') {
+            pos++;
+            if (pos < length && sourceLine[pos].toLower() == 'x') {
+                pos++;
+                if (pos < length && sourceLine[pos].toLower() == 'f') {
+                    pos++;
+                }
+            }
+            else if (pos < length && sourceLine[pos].toLower() == 'f') {
+                pos++;
+            }
+        }
+        else {
             tokenString = ";ERROR: Malformed addressing mode.";
             return false;
         }
         token = LT_ADDRESSING_MODE;
-        tokenString = rxAddrMode.capturedTexts()[0];
-        sourceLine.remove(0, tokenString.length());
-        return true;
     }
-    if (firstChar == '\'') {
-        if (rxCharConst.indexIn(sourceLine) == -1) {
+    else if (firstChar == '\'') {
+        pos++;
+        int charLength = quotedCharLength(sourceLine, pos, '\'');
+        if (charLength == 0 || pos + charLength >= length || sourceLine[pos + charLength] != '\'') {
             tokenString = ";ERROR: Malformed character constant.";
             return false;
         }
+        pos += charLength + 1;
         token = LT_CHAR_CONSTANT;
-        tokenString = rxCharConst.capturedTexts()[0];
-        sourceLine.remove(0, tokenString.length());
-        return true;
     }
-    if (firstChar == ';') {
-        if (rxComment.indexIn(sourceLine) == -1) {
-            // This error should not occur, as any characters are allowed in a comment.
-            tokenString = ";ERROR: Malformed comment";
-            return false;
+    else if (firstChar == ';') {
+        // Any characters are allowed in a comment. Trailing white space is not part of the token.
+        pos = length;
+        while (sourceLine[pos - 1].isSpace()) {
+            pos--;
         }
         token = LT_COMMENT;
-        tokenString = rxComment.capturedTexts()[0];
-        sourceLine.remove(0, tokenString.length());
-        return true;
     }
-    if (startsWithHexPrefix(sourceLine)) {
-        if (rxHexConst.indexIn(sourceLine) == -1) {
+    else if (firstChar == '0' && pos + 1 < length && (sourceLine[pos + 1] == 'x' || sourceLine[pos + 1] == 'X')) {
+        pos += 2;
+        while (pos < length && isHexDigit(sourceLine[pos])) {
+            pos++;
+        }
+        if (pos == start + 2) {
             tokenString = ";ERROR: Malformed hex constant.";
             return false;
         }
         token = LT_HEX_CONSTANT;
-        tokenString = rxHexConst.capturedTexts()[0];
-        sourceLine.remove(0, tokenString.length());
-        return true;
     }
-    if ((firstChar.isDigit() || firstChar == '+' || firstChar == '-')) {
-        if (rxDecConst.indexIn(sourceLine) == -1) {
+    else if (firstChar.isDigit() || firstChar == '+' || firstChar == '-') {
+        if (firstChar == '+' || firstChar == '-') {
+            pos++;
+        }
+        int digitStart = pos;
+        while (pos < length && sourceLine[pos] >= '0' && sourceLine[pos] <= '9') {
+            pos++;
+        }
+        if (pos == digitStart) {
             tokenString = ";ERROR: Malformed decimal constant.";
             return false;
         }
         token = LT_DEC_CONSTANT;
-        tokenString = rxDecConst.capturedTexts()[0];
-        sourceLine.remove(0, tokenString.length());
-        return true;
     }
-    if (firstChar == '.') {
-        if (rxDotCommand.indexIn(sourceLine) == -1) {
+    else if (firstChar == '.') {
+        pos++;
+        if (pos >= length || !isAsciiLetter(sourceLine[pos])) {
             tokenString = ";ERROR: Malformed dot command.";
             return false;
         }
+        while (pos < length && isWordChar(sourceLine[pos])) {
+            pos++;
+        }
         token = LT_DOT_COMMAND;
-        tokenString = rxDotCommand.capturedTexts()[0];
-        sourceLine.remove(0, tokenString.length());
-        return true;
     }
-    if (firstChar.isLetter() || firstChar == '_') {
-        if (rxIdentifier.indexIn(sourceLine) == -1) {
-            // This error should not occur, as one-character identifiers are valid.
+    else if (firstChar.isLetter() || firstChar == '_') {
+        if (!isAsciiLetter(firstChar) && firstChar != '_') {
             tokenString = ";ERROR: Malformed identifier.";
             return false;
         }
-        tokenString = rxIdentifier.capturedTexts()[0];
-        token = tokenString.endsWith(':') ? LT_SYMBOL_DEF : LT_IDENTIFIER;
-        sourceLine.remove(0, tokenString.length());
-        return true;
+        pos++;
+        while (pos < length && isWordChar(sourceLine[pos])) {
+            pos++;
+        }
+        if (pos < length && sourceLine[pos] == ':') {
+            pos++;
+            token = LT_SYMBOL_DEF;
+        }
+        else {
+            token = LT_IDENTIFIER;
+        }
     }
-    if (firstChar == '\"') {
-        if (rxStringConst.indexIn(sourceLine) == -1) {
+    else if (firstChar == '\"') {
+        pos++;
+        while (pos < length && sourceLine[pos] != '\"') {
+            int charLength = quotedCharLength(sourceLine, pos, '\"');
+            if (charLength == 0) {
+                break;
+            }
+            pos += charLength;
+        }
+        if (pos >= length || sourceLine[pos] != '\"') {
             tokenString = ";ERROR: Malformed string constant.";
             return false;
         }
+        pos++;
         token = LT_STRING_CONSTANT;
-        tokenString = rxStringConst.capturedTexts()[0];
-        sourceLine.remove(0, tokenString.length());
-        return true;
     }
-    tokenString = ";ERROR: Syntax error.";
-    return false;
+    else {
+        tokenString = ";ERROR: Syntax error.";
+        return false;
+    }
+    tokenString = sourceLine.mid(start, pos - start);
+    cursor = pos;
+    return true;
+}
+
+QString Asm::identifierAt(const QString &sourceLine, int position)
+{
+    int start = qMin(position, sourceLine.length());
+    while (start > 0 && isWordChar(sourceLine[start - 1])) {
+        start--;
+    }
+    int end = start;
+    while (end < sourceLine.length() && isWordChar(sourceLine[end])) {
+        end++;
+    }
+    if (end == start || !(isAsciiLetter(sourceLine[start]) || sourceLine[start] == '_')) {
+        return "";
+    }
+    return sourceLine.mid(start, end - start);
 }
 
 QList<QString> Asm::listOfReferencedSymbols;
 QList<int> Asm::listOfReferencedSymbolLineNums;
 
 
-bool Asm::startsWithHexPrefix(QString str)
-{
-    if (str.length() < 2) return false;
-    if (str[0] != '0') return false;
-    if (str[1] == 'x' || str[1] == 'X') return true;
-    return false;
-}
-
 Enu::EAddrMode Asm::stringToAddrMode(QString str)
 {
     str.remove(0, 1); // Remove the comma.
@@ -284,12 +368,15 @@ int Asm::formatMultiplier(QString formatTag) {
     }
 }
 
-bool Asm::processSourceLine(QString sourceLine, int lineNum, Code *&code, QString &errorString, bool &dotEndDetected)
+bool Asm::parseSourceLine(QString sourceLine, int lineNum, ParsedLine &parsed)
 {
     Asm::ELexicalToken token; // Passed to getToken.
     QString tokenString; // Passed to getToken.
+    int cursor = 0; // Passed to getToken.
     QString localSymbolDef = ""; // Saves symbol definition for processing in the following state.
     Enu::EMnemonic localEnumMnemonic; // Key to Pep:: table lookups.
+    Code *&code = parsed.code; // Deleted by parseLine if the line does not parse.
+    QString &errorString = parsed.errorString;
 
     // The concrete code objects asssigned to code.
     UnaryInstruction *unaryInstruction = NULL;
@@ -305,10 +392,16 @@ bool Asm::processSourceLine(QString sourceLine, int lineNum, Code *&code, QStrin
     CommentOnly *commentOnly = NULL;
     BlankLine *blankLine = NULL;
 
-    dotEndDetected = false;
+    parsed.code = NULL;
+    parsed.byteLength = 0;
+    parsed.symbolDef = "";
+    parsed.symbolRef = NULL;
+    parsed.definesEquate = false;
+    parsed.isDotBurn = false;
+    parsed.dotEndDetected = false;
     Asm::ParseState state = Asm::PS_START;
     do {
-        if (!getToken(sourceLine, token, tokenString)) {
+        if (!getToken(sourceLine, cursor, token, tokenString)) {
             errorString = tokenString;
             return false;
         }
@@ -322,8 +415,7 @@ bool Asm::processSourceLine(QString sourceLine, int lineNum, Code *&code, QStrin
                         unaryInstruction->symbolDef = "";
                         unaryInstruction->mnemonic = localEnumMnemonic;
                         code = unaryInstruction;
-                        code->memAddress = Pep::byteCount;
-                        Pep::byteCount += 1; // One byte generated for unary instruction.
+                        parsed.byteLength += 1; // One byte generated for unary instruction.
                         state = Asm::PS_CLOSE;
                     }
                     else {
@@ -331,8 +423,7 @@ bool Asm::processSourceLine(QString sourceLine, int lineNum, Code *&code, QStrin
                         nonUnaryInstruction->symbolDef = "";
                         nonUnaryInstruction->mnemonic = localEnumMnemonic;
                         code = nonUnaryInstruction;
-                        code->memAddress = Pep::byteCount;
-                        Pep::byteCount += 3; // Three bytes generated for nonunary instruction.
+                        parsed.byteLength += 3; // Three bytes generated for nonunary instruction.
                         state = Asm::PS_INSTRUCTION;
                     }
                 }
@@ -348,57 +439,49 @@ bool Asm::processSourceLine(QString sourceLine, int lineNum, Code *&code, QStrin
                     dotAddrss = new DotAddrss;
                     dotAddrss->symbolDef = "";
                     code = dotAddrss;
-                    code->memAddress = Pep::byteCount;
                     state = Asm::PS_DOT_ADDRSS;
                 }
                 else if (tokenString == "ASCII") {
                     dotAscii = new DotAscii;
                     dotAscii->symbolDef = "";
                     code = dotAscii;
-                    code->memAddress = Pep::byteCount;
                     state = Asm::PS_DOT_ASCII;
                 }
                 else if (tokenString == "BLOCK") {
                     dotBlock = new DotBlock;
                     dotBlock->symbolDef = "";
                     code = dotBlock;
-                    code->memAddress = Pep::byteCount;
                     state = Asm::PS_DOT_BLOCK;
                 }
                 else if (tokenString == "BURN") {
                     dotBurn = new DotBurn;
                     dotBurn->symbolDef = "";
                     code = dotBurn;
-                    code->memAddress = Pep::byteCount;
                     state = Asm::PS_DOT_BURN;
                 }
                 else if (tokenString == "BYTE") {
                     dotByte = new DotByte;
                     dotByte->symbolDef = "";
                     code = dotByte;
-                    code->memAddress = Pep::byteCount;
                     state = Asm::PS_DOT_BYTE;
                 }
                 else if (tokenString == "END") {
                     dotEnd = new DotEnd;
                     dotEnd->symbolDef = "";
                     code = dotEnd;
-                    code->memAddress = Pep::byteCount;
-                    dotEndDetected = true;
+                    parsed.dotEndDetected = true;
                     state = Asm::PS_DOT_END;
                 }
                 else if (tokenString == "EQUATE") {
                     dotEquate = new DotEquate;
                     dotEquate->symbolDef = "";
                     code = dotEquate;
-                    code->memAddress = Pep::byteCount;
                     state = Asm::PS_DOT_EQUATE;
                 }
                 else if (tokenString == "WORD") {
                     dotWord = new DotWord;
                     dotWord->symbolDef = "";
                     code = dotWord;
-                    code->memAddress = Pep::byteCount;
                     state = Asm::PS_DOT_WORD;
                 }
                 else {
@@ -412,26 +495,19 @@ bool Asm::processSourceLine(QString sourceLine, int lineNum, Code *&code, QStrin
                     errorString = ";ERROR: Symbol " + tokenString + " cannot have more than eight characters.";
                     return false;
                 }
-                if (Pep::symbolTable.contains(tokenString)) {
-                    errorString = ";ERROR: Symbol " + tokenString + " was previously defined.";
-                    return false;
-                }
                 localSymbolDef = tokenString;
-                Pep::symbolTable.insert(localSymbolDef, Pep::byteCount);
-                Pep::adjustSymbolValueForBurn.insert(localSymbolDef, true);
+                parsed.symbolDef = tokenString; // Defined in source order by assembleSourceLines.
                 state = Asm::PS_SYMBOL_DEF;
             }
             else if (token == Asm::LT_COMMENT) {
                 commentOnly = new CommentOnly;
                 commentOnly->comment = tokenString;
                 code = commentOnly;
-                code->memAddress = Pep::byteCount;
                 state = Asm::PS_COMMENT;
             }
             else if (token == Asm::LT_EMPTY) {
                 blankLine = new BlankLine;
                 code = blankLine;
-                code->memAddress = Pep::byteCount;
                 code->sourceCodeLine = lineNum;
                 state = Asm::PS_FINISH;
             }
@@ -450,8 +526,7 @@ bool Asm::processSourceLine(QString sourceLine, int lineNum, Code *&code, QStrin
                         unaryInstruction->symbolDef = localSymbolDef;
                         unaryInstruction->mnemonic = localEnumMnemonic;
                         code = unaryInstruction;
-                        code->memAddress = Pep::byteCount;
-                        Pep::byteCount += 1; // One byte generated for unary instruction.
+                        parsed.byteLength += 1; // One byte generated for unary instruction.
                         state = Asm::PS_CLOSE;
                     }
                     else {
@@ -459,8 +534,7 @@ bool Asm::processSourceLine(QString sourceLine, int lineNum, Code *&code, QStrin
                         nonUnaryInstruction->symbolDef = localSymbolDef;
                         nonUnaryInstruction->mnemonic = localEnumMnemonic;
                         code = nonUnaryInstruction;
-                        code->memAddress = Pep::byteCount;
-                        Pep::byteCount += 3; // Three bytes generated for unary instruction.
+                        parsed.byteLength += 3; // Three bytes generated for unary instruction.
                         state = Asm::PS_INSTRUCTION;
                     }
                 }
@@ -476,57 +550,49 @@ bool Asm::processSourceLine(QString sourceLine, int lineNum, Code *&code, QStrin
                     dotAddrss = new DotAddrss;
                     dotAddrss->symbolDef = localSymbolDef;
                     code = dotAddrss;
-                    code->memAddress = Pep::byteCount;
                     state = Asm::PS_DOT_ADDRSS;
                 }
                 else if (tokenString == "ASCII") {
                     dotAscii = new DotAscii;
                     dotAscii->symbolDef = localSymbolDef;
                     code = dotAscii;
-                    code->memAddress = Pep::byteCount;
                     state = Asm::PS_DOT_ASCII;
                 }
                 else if (tokenString == "BLOCK") {
                     dotBlock = new DotBlock;
                     dotBlock->symbolDef = localSymbolDef;
                     code = dotBlock;
-                    code->memAddress = Pep::byteCount;
                     state = Asm::PS_DOT_BLOCK;
                 }
                 else if (tokenString == "BURN") {
                     dotBurn = new DotBurn;
                     dotBurn->symbolDef = localSymbolDef;
                     code = dotBurn;
-                    code->memAddress = Pep::byteCount;
                     state = Asm::PS_DOT_BURN;
                 }
                 else if (tokenString == "BYTE") {
                     dotByte = new DotByte;
                     dotByte->symbolDef = localSymbolDef;
                     code = dotByte;
-                    code->memAddress = Pep::byteCount;
                     state = Asm::PS_DOT_BYTE;
                 }
                 else if (tokenString == "END") {
                     dotEnd = new DotEnd;
                     dotEnd->symbolDef = localSymbolDef;
                     code = dotEnd;
-                    code->memAddress = Pep::byteCount;
-                    dotEndDetected = true;
+                    parsed.dotEndDetected = true;
                     state = Asm::PS_DOT_END;
                 }
                 else if (tokenString == "EQUATE") {
                     dotEquate = new DotEquate;
                     dotEquate->symbolDef = localSymbolDef;
                     code = dotEquate;
-                    code->memAddress = Pep::byteCount;
                     state = Asm::PS_DOT_EQUATE;
                 }
                 else if (tokenString == "WORD") {
                     dotWord = new DotWord;
                     dotWord->symbolDef = localSymbolDef;
                     code = dotWord;
-                    code->memAddress = Pep::byteCount;
                     state = Asm::PS_DOT_WORD;
                 }
                 else {
@@ -546,9 +612,8 @@ bool Asm::processSourceLine(QString sourceLine, int lineNum, Code *&code, QStrin
                     errorString = ";ERROR: Symbol " + tokenString + " cannot have more than eight characters.";
                     return false;
                 }
-                nonUnaryInstruction->argument = new SymbolRefArgument(tokenString);
-                Asm::listOfReferencedSymbols.append(tokenString);
-                Asm::listOfReferencedSymbolLineNums.append(lineNum);
+                parsed.symbolRef = new SymbolRefArgument(tokenString);
+                nonUnaryInstruction->argument = parsed.symbolRef;
                 state = Asm::PS_ADDRESSING_MODE;
             }
             else if (token == Asm::LT_STRING_CONSTANT) {
@@ -637,10 +702,9 @@ bool Asm::processSourceLine(QString sourceLine, int lineNum, Code *&code, QStrin
                     errorString = ";ERROR: Symbol " + tokenString + " cannot have more than eight characters.";
                     return false;
                 }
-                dotAddrss->argument = new SymbolRefArgument(tokenString);
-                Asm::listOfReferencedSymbols.append(tokenString);
-                Asm::listOfReferencedSymbolLineNums.append(lineNum);
-                Pep::byteCount += 2;
+                parsed.symbolRef = new SymbolRefArgument(tokenString);
+                dotAddrss->argument = parsed.symbolRef;
+                parsed.byteLength += 2;
                 state = Asm::PS_CLOSE;
             }
             else {
@@ -652,7 +716,7 @@ bool Asm::processSourceLine(QString sourceLine, int lineNum, Code *&code, QStrin
         case Asm::PS_DOT_ASCII:
             if (token == Asm::LT_STRING_CONSTANT) {
                 dotAscii->argument = new StringArgument(tokenString);
-                Pep::byteCount += Asm::byteStringLength(tokenString);
+                parsed.byteLength += Asm::byteStringLength(tokenString);
                 state = Asm::PS_CLOSE;
             }
             else {
@@ -673,7 +737,7 @@ bool Asm::processSourceLine(QString sourceLine, int lineNum, Code *&code, QStrin
                     else {
                         dotBlock->argument = new UnsignedDecArgument(value);
                     }
-                    Pep::byteCount += value;
+                    parsed.byteLength += value;
                     state = Asm::PS_CLOSE;
                 }
                 else {
@@ -687,7 +751,7 @@ bool Asm::processSourceLine(QString sourceLine, int lineNum, Code *&code, QStrin
                 int value = tokenString.toInt(&ok, 16);
                 if (value < 65536) {
                     dotBlock->argument = new HexArgument(value);
-                    Pep::byteCount += value;
+                    parsed.byteLength += value;
                     state = Asm::PS_CLOSE;
                 }
                 else {
@@ -708,9 +772,8 @@ bool Asm::processSourceLine(QString sourceLine, int lineNum, Code *&code, QStrin
                 int value = tokenString.toInt(&ok, 16);
                 if (value < 65536) {
                     dotBurn->argument = new HexArgument(value);
-                    Pep::burnCount++;
-                    Pep::dotBurnArgument = value;
-                    Pep::romStartAddress = Pep::byteCount;
+                    parsed.isDotBurn = true;
+                    parsed.burnValue = value;
                     state = Asm::PS_CLOSE;
                 }
                 else {
@@ -727,7 +790,7 @@ bool Asm::processSourceLine(QString sourceLine, int lineNum, Code *&code, QStrin
         case Asm::PS_DOT_BYTE:
             if (token == Asm::LT_CHAR_CONSTANT) {
                 dotByte->argument = new CharArgument(tokenString);
-                Pep::byteCount += 1;
+                parsed.byteLength += 1;
                 state = Asm::PS_CLOSE;
             }
             else if (token == Asm::LT_DEC_CONSTANT) {
@@ -738,7 +801,7 @@ bool Asm::processSourceLine(QString sourceLine, int lineNum, Code *&code, QStrin
                         value += 256; // value stored as one-byte unsigned.
                     }
                     dotByte->argument = new DecArgument(value);
-                    Pep::byteCount += 1;
+                    parsed.byteLength += 1;
                     state = Asm::PS_CLOSE;
                 }
                 else {
@@ -752,7 +815,7 @@ bool Asm::processSourceLine(QString sourceLine, int lineNum, Code *&code, QStrin
                 int value = tokenString.toInt(&ok, 16);
                 if (value < 256) {
                     dotByte->argument = new HexArgument(value);
-                    Pep::byteCount += 1;
+                    parsed.byteLength += 1;
                     state = Asm::PS_CLOSE;
                 }
                 else {
@@ -766,7 +829,7 @@ bool Asm::processSourceLine(QString sourceLine, int lineNum, Code *&code, QStrin
                     return false;
                 }
                 dotByte->argument = new StringArgument(tokenString);
-                Pep::byteCount += 1;
+                parsed.byteLength += 1;
                 state = Asm::PS_CLOSE;
             }
             else {
@@ -809,8 +872,8 @@ bool Asm::processSourceLine(QString sourceLine, int lineNum, Code *&code, QStrin
                     else {
                         dotEquate->argument = new UnsignedDecArgument(value);
                     }
-                    Pep::symbolTable.insert(dotEquate->symbolDef, value);
-                    Pep::adjustSymbolValueForBurn.insert(dotEquate->symbolDef, false);
+                    parsed.definesEquate = true;
+                    parsed.equateValue = value;
                     state = Asm::PS_CLOSE;
                 }
                 else {
@@ -824,8 +887,8 @@ bool Asm::processSourceLine(QString sourceLine, int lineNum, Code *&code, QStrin
                 int value = tokenString.toInt(&ok, 16);
                 if (value < 65536) {
                     dotEquate->argument = new HexArgument(value);
-                    Pep::symbolTable.insert(dotEquate->symbolDef, value);
-                    Pep::adjustSymbolValueForBurn.insert(dotEquate->symbolDef, false);
+                    parsed.definesEquate = true;
+                    parsed.equateValue = value;
                     state = Asm::PS_CLOSE;
                 }
                 else {
@@ -839,8 +902,8 @@ bool Asm::processSourceLine(QString sourceLine, int lineNum, Code *&code, QStrin
                     return false;
                 }
                 dotEquate->argument = new StringArgument(tokenString);
-                Pep::symbolTable.insert(dotEquate->symbolDef, Asm::string2ArgumentToInt(tokenString));
-                Pep::adjustSymbolValueForBurn.insert(dotEquate->symbolDef, false);
+                parsed.definesEquate = true;
+                parsed.equateValue = Asm::string2ArgumentToInt(tokenString);
                 state = Asm::PS_CLOSE;
             }
             else {
@@ -852,7 +915,7 @@ bool Asm::processSourceLine(QString sourceLine, int lineNum, Code *&code, QStrin
         case Asm::PS_DOT_WORD:
             if (token == Asm::LT_CHAR_CONSTANT) {
                 dotWord->argument = new CharArgument(tokenString);
-                Pep::byteCount += 2;
+                parsed.byteLength += 2;
                 state = Asm::PS_CLOSE;
             }
             else if (token == Asm::LT_DEC_CONSTANT) {
@@ -867,7 +930,7 @@ bool Asm::processSourceLine(QString sourceLine, int lineNum, Code *&code, QStrin
                     else {
                         dotWord->argument = new UnsignedDecArgument(value);
                     }
-                    Pep::byteCount += 2;
+                    parsed.byteLength += 2;
                     state = Asm::PS_CLOSE;
                 }
                 else {
@@ -881,7 +944,7 @@ bool Asm::processSourceLine(QString sourceLine, int lineNum, Code *&code, QStrin
                 int value = tokenString.toInt(&ok, 16);
                 if (value < 65536) {
                     dotWord->argument = new HexArgument(value);
-                    Pep::byteCount += 2;
+                    parsed.byteLength += 2;
                     state = Asm::PS_CLOSE;
                 }
                 else {
@@ -895,7 +958,7 @@ bool Asm::processSourceLine(QString sourceLine, int lineNum, Code *&code, QStrin
                     return false;
                 }
                 dotWord->argument = new StringArgument(tokenString);
-                Pep::byteCount += 2;
+                parsed.byteLength += 2;
                 state = Asm::PS_CLOSE;
             }
             else {
@@ -938,3 +1001,229 @@ bool Asm::processSourceLine(QString sourceLine, int lineNum, Code *&code, QStrin
     while (state != Asm::PS_FINISH);
     return true;
 }
+
+void Asm::parseLine(ParsedLine &parsed)
+{
+    if (!parseSourceLine(parsed.sourceLine, parsed.lineNum, parsed)) {
+        delete parsed.code;
+        parsed.code = NULL;
+        parsed.symbolRef = NULL;
+    }
+}
+
+bool Asm::assembleSourceLines(const QStringList &sourceCodeList, QVector<ParsedLine> &parsedLines, QList<Code *> &codeList,
+                              int &lineNum, QString &errorString, bool &dotEndDetected)
+{
+    // Phase 1: Reparse only the lines between the unchanged first and last lines of the previous parse.
+    int oldSize = parsedLines.size();
+    int newSize = sourceCodeList.size();
+    int prefixSize = 0;
+    while (prefixSize < oldSize && prefixSize < newSize
+           && parsedLines[prefixSize].sourceLine == sourceCodeList[prefixSize]) {
+        prefixSize++;
+    }
+    int suffixSize = 0;
+    while (suffixSize < oldSize - prefixSize && suffixSize < newSize - prefixSize
+           && parsedLines[oldSize - 1 - suffixSize].sourceLine == sourceCodeList[newSize - 1 - suffixSize]) {
+        suffixSize++;
+    }
+    for (int i = prefixSize; i < oldSize - suffixSize; i++) {
+        delete parsedLines[i].code;
+    }
+    QVector<ParsedLine> changedLines(newSize - prefixSize - suffixSize);
+    for (int i = 0; i < changedLines.size(); i++) {
+        changedLines[i].sourceLine = sourceCodeList[prefixSize + i];
+        changedLines[i].lineNum = prefixSize + i;
+    }
+    if (changedLines.size() >= Asm::parallelParseThreshold) {
+        QtConcurrent::blockingMap(changedLines, Asm::parseLine);
+    }
+    else {
+        for (int i = 0; i < changedLines.size(); i++) {
+            parseLine(changedLines[i]);
+        }
+    }
+    QVector<ParsedLine> lines;
+    lines.reserve(newSize);
+    for (int i = 0; i < prefixSize; i++) {
+        lines.append(parsedLines[i]);
+    }
+    for (int i = 0; i < changedLines.size(); i++) {
+        lines.append(changedLines[i]);
+    }
+    int lineDelta = newSize - oldSize;
+    for (int i = oldSize - suffixSize; i < oldSize; i++) {
+        ParsedLine &parsed = parsedLines[i];
+        parsed.lineNum += lineDelta;
+        if (parsed.code != NULL) {
+            parsed.code->sourceCodeLine = parsed.lineNum;
+        }
+        lines.append(parsed);
+    }
+    parsedLines = lines;
+
+    // Phase 2: Assign addresses and define symbols in source order, stopping at .END.
+    dotEndDetected = false;
+    lineNum = 0;
+    while (lineNum < parsedLines.size() && !dotEndDetected) {
+        const ParsedLine &parsed = parsedLines.at(lineNum);
+        if (parsed.symbolDef != "") {
+            if (Pep::isSymbolDefined(parsed.symbolDef)) {
+                errorString = ";ERROR: Symbol " + parsed.symbolDef + " was previously defined.";
+                return false;
+            }
+            Pep::defineSymbol(parsed.symbolDef, Pep::byteCount, Enu::K_LABEL, lineNum);
+        }
+        if (parsed.code == NULL) {
+            errorString = parsed.errorString;
+            return false;
+        }
+        parsed.code->memAddress = Pep::byteCount;
+        codeList.append(parsed.code);
+        if (parsed.symbolRef != NULL) {
+            parsed.symbolRef->symbolId = Pep::internSymbol(parsed.symbolRef->symbolRefValue);
+            Pep::referenceSymbol(parsed.symbolRef->symbolId, lineNum);
+            Asm::listOfReferencedSymbols.append(parsed.symbolRef->symbolRefValue);
+            Asm::listOfReferencedSymbolLineNums.append(lineNum);
+        }
+        if (parsed.definesEquate) {
+            Pep::defineSymbol(parsed.symbolDef, parsed.equateValue, Enu::K_EQUATE, lineNum);
+        }
+        if (parsed.isDotBurn) {
+            Pep::burnCount++;
+            Pep::dotBurnArgument = parsed.burnValue;
+            Pep::romStartAddress = Pep::byteCount;
+        }
+        Pep::byteCount += parsed.byteLength;
+        dotEndDetected = parsed.dotEndDetected;
+        lineNum++;
+    }
+    return true;
+}
+
+bool Asm::assembleProgram(const QStringList &sourceCodeList, QVector<ParsedLine> &parsedLines, QList<Code *> &codeList,
+                          Enu::EAssembly assembly, QList<int> &objectCode, int &lineNum, QString &errorString)
+{
+    bool dotEndDetected = false;
+    listOfReferencedSymbols.clear();
+    listOfReferencedSymbolLineNums.clear();
+    Pep::clearSymbolTable();
+    codeList.clear();
+    objectCode.clear();
+    Pep::byteCount = 0;
+    Pep::burnCount = 0;
+    lineNum = 0;
+    if (!assembleSourceLines(sourceCodeList, parsedLines, codeList, lineNum, errorString, dotEndDetected)) {
+        return false;
+    }
+    lineNum = 0;
+    if (!dotEndDetected) {
+        errorString = ";ERROR: Missing .END sentinel.";
+        return false;
+    }
+    if (Pep::byteCount > 65535) {
+        errorString = ";ERROR: Object code size too large to fit into memory.";
+        return false;
+    }
+    for (int i = 0; i < listOfReferencedSymbols.length() && assembly != Enu::EModule; i++) {
+        if (!Pep::isSymbolDefined(listOfReferencedSymbols[i])) {
+            lineNum = listOfReferencedSymbolLineNums[i];
+            errorString = ";ERROR: Symbol " + listOfReferencedSymbols[i] + " is used but not defined.";
+            return false;
+        }
+    }
+    if (assembly == Enu::EOperatingSystem) {
+        if (Pep::burnCount == 0) {
+            errorString = ";ERROR: .BURN required to install OS.";
+            return false;
+        }
+        if (Pep::burnCount > 1) {
+            errorString = ";ERROR: Program contain more than one .BURN.";
+            return false;
+        }
+        // Adjust for .BURN
+        int addressDelta = Pep::dotBurnArgument - Pep::byteCount + 1;
+        Pep::adjustSymbolValuesForBurn(addressDelta);
+        for (int i = 0; i < codeList.size(); i++) {
+            codeList[i]->adjustMemAddress(addressDelta);
+        }
+        Pep::romStartAddress += addressDelta;
+    }
+    else if (Pep::burnCount > 0) {
+        errorString = assembly == Enu::EModule ? ";ERROR: .BURN not allowed in a module."
+                                               : ";ERROR: .BURN not allowed in program unless installing OS.";
+        return false;
+    }
+    for (int i = 0; i < codeList.size(); i++) {
+        codeList[i]->appendObjectCode(objectCode);
+    }
+    return true;
+}
+
+void Asm::clearParsedLines(QVector<ParsedLine> &parsedLines)
+{
+    for (int i = 0; i < parsedLines.size(); i++) {
+        delete parsedLines[i].code;
+    }
+    parsedLines.clear();
+}
+
+void Asm::checkSourceLines(const QStringList &sourceCodeList, QVector<ParsedLine> &parsedLines,
+                           QMap<int, QString> &errorOfLine, Pep::CrossReferenceIndex &crossReferences)
+{
+    parsedLines.resize(sourceCodeList.size());
+    for (int i = 0; i < parsedLines.size(); i++) {
+        parsedLines[i].sourceLine = sourceCodeList[i];
+        parsedLines[i].lineNum = i;
+        parseLine(parsedLines[i]);
+    }
+
+    // The same checks as assembleSourceLines and SourceCodePane::assemble, with a local symbol
+    // table, and going on past the first error.
+    QSet<QString> definedSymbols;
+    QList<int> referenceLineNums;
+    int byteCount = 0;
+    bool dotEndDetected = false;
+    int lineNum = 0;
+    while (lineNum < parsedLines.size() && !dotEndDetected) {
+        const ParsedLine &parsed = parsedLines.at(lineNum);
+        if (parsed.symbolDef != "") {
+            if (definedSymbols.contains(parsed.symbolDef)) {
+                errorOfLine.insert(lineNum, ";ERROR: Symbol " + parsed.symbolDef + " was previously defined.");
+            }
+            definedSymbols.insert(parsed.symbolDef);
+            // The first definition counts, as for the assembler.
+            if (!crossReferences.contains(parsed.symbolDef) || crossReferences[parsed.symbolDef].definitionLineNum < 0) {
+                crossReferences[parsed.symbolDef].definitionLineNum = lineNum;
+            }
+        }
+        if (parsed.code == NULL) {
+            errorOfLine.insert(lineNum, parsed.errorString);
+        }
+        else {
+            if (parsed.symbolRef != NULL) {
+                referenceLineNums.append(lineNum);
+                const QString &symbol = parsed.symbolRef->symbolRefValue;
+                if (!crossReferences.contains(symbol)) {
+                    crossReferences[symbol].definitionLineNum = -1;
+                }
+                crossReferences[symbol].referenceLineNums.append(lineNum);
+            }
+            byteCount += parsed.byteLength;
+            dotEndDetected = parsed.dotEndDetected;
+        }
+        lineNum++;
+    }
+    for (int i = 0; i < referenceLineNums.size(); i++) {
+        const QString &symbol = parsedLines.at(referenceLineNums[i]).symbolRef->symbolRefValue;
+        if (!definedSymbols.contains(symbol) && !errorOfLine.contains(referenceLineNums[i])) {
+            errorOfLine.insert(referenceLineNums[i], ";ERROR: Symbol " + symbol + " is used but not defined.");
+        }
+    }
+    if (!dotEndDetected && !errorOfLine.contains(0)) {
+        errorOfLine.insert(0, ";ERROR: Missing .END sentinel.");
+    }
+    else if (byteCount > 65535 && !errorOfLine.contains(0)) {
+        errorOfLine.insert(0, ";ERROR: Object code size too large to fit into memory.");
+    }
+}
@@ -22,10 +22,15 @@
 #ifndef ASM_H
 #define ASM_H
 
+#include <QMap>
 #include <QRegExp>
+#include <QStringList>
+#include <QVector>
 #include "enu.h"
+#include "pep.h"
 
-class Code; // Forward declaration for argument of processSourceLine.
+class Code; // Forward declaration for argument of parseSourceLine.
+class SymbolRefArgument;
 
 class Asm
 {
@@ -44,41 +49,96 @@ public:
         PS_INSTRUCTION, PS_START, PS_STRING, PS_SYMBOL_DEF
     };
 
-    // Regular expressions for lexical analysis
-    static QRegExp rxAddrMode;
-    static QRegExp rxCharConst;
-    static QRegExp rxComment;
-    static QRegExp rxDecConst;
-    static QRegExp rxDotCommand;
-    static QRegExp rxHexConst;
-    static QRegExp rxIdentifier;
-    static QRegExp rxStringConst;
-
     // Regular expressions for trace tag analysis
     static QRegExp rxFormatTag;
     static QRegExp rxSymbolTag;
     static QRegExp rxArrayMultiplier;
 
-    static bool getToken(QString &sourceLine, ELexicalToken &token, QString &tokenString);
+    static bool getToken(const QString &sourceLine, int &cursor, ELexicalToken &token, QString &tokenString);
     // Pre: sourceLine has one line of source code.
-    // Post: If the next token is valid, the string of characters representing the next token are deleted from the
-    // beginning of sourceLine and returned in tokenString, true is returned, and token is set to the token type.
+    // Pre: cursor is the index in sourceLine at which scanning starts.
+    // Post: If the next token is valid, the string of characters representing the next token is returned
+    // in tokenString, cursor is advanced past it, true is returned, and token is set to the token type.
     // Post: If false is returned, then tokenString is set to the lexical error message.
 
-    static bool processSourceLine(QString sourceLine, int lineNum, Code *&code, QString &errorString, bool &dotEndDetected);
+    static QString identifierAt(const QString &sourceLine, int position);
+    // Post: Returns the identifier of sourceLine that contains position or ends at it, or "" if there is none.
+
+    // The result of parsing one source line. Parsing depends on no other line, so lines can be
+    // parsed concurrently. Addresses and symbol values are assigned afterwards in source order.
+    struct ParsedLine
+    {
+        QString sourceLine;
+        int lineNum;
+        Code *code;
+        QString errorString;
+        int byteLength; // Number of bytes of object code generated.
+        QString symbolDef; // Symbol defined on the line, set even if the rest of the line has an error.
+        SymbolRefArgument *symbolRef; // Symbol referenced by the operand, or NULL.
+        bool definesEquate;
+        int equateValue;
+        bool isDotBurn;
+        int burnValue;
+        bool dotEndDetected;
+    };
+
+    // Sources with at least this many lines are parsed on all cores.
+    static const int parallelParseThreshold = 1000;
+
+    static bool parseSourceLine(QString sourceLine, int lineNum, ParsedLine &parsed);
     // Pre: sourceLine has one line of source code.
     // Pre: lineNum is the line number of the source code.
-    // Post: If the source line is valid, true is returned and code is set to the source code for the line.
+    // Post: If the source line is valid, true is returned and parsed.code is set to the source code
+    // for the line, with byteLength, symbolDef, symbolRef and the .EQUATE, .BURN and .END fields set.
+    // Post: If the source line is not valid, false is returned and parsed.errorString is set to the error message.
+    // Post: No global state is modified.
+
+    static void parseLine(ParsedLine &parsed);
+    // Pre: parsed.sourceLine and parsed.lineNum are set.
+    // Post: parsed is set by parseSourceLine. If the line is not valid, parsed.code is deleted and set to NULL.
+
+    static bool assembleSourceLines(const QStringList &sourceCodeList, QVector<ParsedLine> &parsedLines, QList<Code *> &codeList,
+                                    int &lineNum, QString &errorString, bool &dotEndDetected);
+    // Pre: The symbol table is clear and Pep::byteCount and Pep::burnCount are 0.
+    // Pre: parsedLines is the parse cache from the previous call, or is empty. It owns the code objects.
+    // Post: The lines of sourceCodeList that are unchanged at the start and end of the previous parse
+    // are reused, shifted to their new line numbers, and only the lines in between are parsed,
+    // concurrently if there are at least parallelParseThreshold of them. parsedLines is the new parse.
+    // Post: Up to and including .END, each line is assigned its address, its symbol is defined,
+    // its symbol reference is resolved, and its code is appended to codeList.
+    // Post: Pep::byteCount is the number of bytes generated and Pep::burnCount the number of .BURN lines.
     // Post: dotEndDetected is set to true if .END is processed. Otherwise it is set to false.
-    // Post: Pep::byteCount is incremented by the number of bytes generated.
-    // Post: If the source line is not valid, false is returned and errorString is set to the error message.
+    // Post: If a line is not valid, false is returned, lineNum is its line number and errorString is
+    // set to the error message. codeList then holds the code for the lines before it.
+
+    static bool assembleProgram(const QStringList &sourceCodeList, QVector<ParsedLine> &parsedLines, QList<Code *> &codeList,
+                                Enu::EAssembly assembly, QList<int> &objectCode, int &lineNum, QString &errorString);
+    // Pre: parsedLines is the parse cache from the previous call, or is empty. It owns the code objects.
+    // Post: The symbol table, the referenced symbols, Pep::byteCount and Pep::burnCount are reset
+    // and sourceCodeList is assembled into codeList by assembleSourceLines.
+    // Post: For an OS, the code and symbol values are adjusted for its .BURN and Pep::romStartAddress
+    // is the start of its image. objectCode is the object code of codeList.
+    // Post: If a line is not valid, .END is missing, the object code is too large for memory, a symbol
+    // is used but not defined in a program or an OS, or .BURN is missing from an OS or not alone in it,
+    // false is returned, lineNum is the line of the error, 0 if it has none, and errorString its message.
+
+    static void clearParsedLines(QVector<ParsedLine> &parsedLines);
+    // Post: The code objects of parsedLines are deleted and parsedLines is cleared.
+
+    static void checkSourceLines(const QStringList &sourceCodeList, QVector<ParsedLine> &parsedLines,
+                                 QMap<int, QString> &errorOfLine, Pep::CrossReferenceIndex &crossReferences);
+    // Pre: parsedLines is empty.
+    // Post: Every line of sourceCodeList is parsed into parsedLines, which owns the code objects.
+    // Post: errorOfLine maps the number of each line up to and including .END that has an error
+    // to its message: lexical and syntax errors, symbols previously defined and symbols used but
+    // not defined. A missing .END and object code too large for memory are reported on line 0.
+    // Post: crossReferences is the cross-reference index of the lines up to and including .END.
+    // Post: No global state is modified, so the check can run on a worker thread while the
+    // assembler runs on the GUI thread.
 
     static QList<QString> listOfReferencedSymbols;
     static QList<int> listOfReferencedSymbolLineNums;
 
-    static bool startsWithHexPrefix(QString str);
-    // Post: Returns true if str starts with the characters 0x or 0X. Otherwise returns false.
-
     static Enu::EAddrMode stringToAddrMode(QString str);
     // Post: Returns the addressing mode integer defined in Pep from its string representation.
 
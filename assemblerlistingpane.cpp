@@ -21,9 +21,12 @@
 
 #include <QScrollBar>
 #include <QFontDialog>
+#include <QTextBlock>
 #include "assemblerlistingpane.h"
 #include "ui_assemblerlistingpane.h"
 #include "pep.h"
+#include "asm.h"
+#include "flowgraph.h"
 
 #include <QMouseEvent>
 
@@ -34,6 +37,7 @@ AssemblerListingPane::AssemblerListingPane(QWidget *parent) :
     ui->setupUi(this);
 
     pepHighlighter = new PepHighlighter(ui->textEdit->document());
+    firstListingBlock = 0;
 
     ui->label->setFont(QFont(Pep::labelFont, Pep::labelFontSize));
     ui->textEdit->setFont(QFont(Pep::codeFont, Pep::codeFontSize));
@@ -44,32 +48,45 @@ AssemblerListingPane::~AssemblerListingPane()
     delete ui;
 }
 
-void AssemblerListingPane::setAssemblerListing(QStringList assemblerListingList) {
+void AssemblerListingPane::setAssemblerListing(QStringList assemblerListingList, QStringList annotationList,
+                                               QStringList summaryList) {
     clearAssemblerListing();
-    ui->textEdit->append("-------------------------------------------------------------------------------");
-    ui->textEdit->append("      Object");
-    ui->textEdit->append("Addr  code   Symbol   Mnemon  Operand     Comment");
-    ui->textEdit->append("-------------------------------------------------------------------------------");
+    QString blank = "";
+    QString rule = "";
+    QString columns = "";
+    if (!annotationList.isEmpty()) {
+        blank = QString(FlowGraph::annotationWidth, ' ');
+        rule = QString(FlowGraph::annotationWidth, '-');
+        columns = QString("%1").arg("Blk  Loop Cost", -FlowGraph::annotationWidth);
+        for (int i = 0; i < assemblerListingList.size(); i++) {
+            assemblerListingList[i].prepend(i < annotationList.size() ? annotationList.at(i) : blank);
+        }
+    }
+    ui->textEdit->append(rule + "-------------------------------------------------------------------------------");
+    ui->textEdit->append(blank + "      Object");
+    ui->textEdit->append(columns + "Addr  code   Symbol   Mnemon  Operand     Comment");
+    ui->textEdit->append(rule + "-------------------------------------------------------------------------------");
+    firstListingBlock = ui->textEdit->document()->blockCount();
     ui->textEdit->append(assemblerListingList.join("\n"));
-    ui->textEdit->append("-------------------------------------------------------------------------------");
-    if (Pep::symbolTable.size() > 0) {
+    ui->textEdit->append(rule + "-------------------------------------------------------------------------------");
+    QList<int> symbolIds = Pep::sortedSymbolIds();
+    if (!symbolIds.isEmpty()) {
         ui->textEdit->append("");
         ui->textEdit->append("");
         ui->textEdit->append("Symbol table");
         ui->textEdit->append("--------------------------------------");
         ui->textEdit->append("Symbol    Value        Symbol    Value");
         ui->textEdit->append("--------------------------------------");
-        QMapIterator<QString, int> i(Pep::symbolTable);
         QString symbolTableLine = "";
         QString hexString;
-        while (i.hasNext()) {
-            i.next();
-            hexString = QString("%1").arg(i.value(), 4, 16, QLatin1Char('0')).toUpper();
+        for (int i = 0; i < symbolIds.size(); i++) {
+            const Pep::Symbol &symbol = Pep::symbols.at(symbolIds.at(i));
+            hexString = QString("%1").arg(symbol.value, 4, 16, QLatin1Char('0')).toUpper();
             if (symbolTableLine.length() == 0) {
-                symbolTableLine = QString("%1%2").arg(i.key(), -10).arg(hexString, -13);
+                symbolTableLine = QString("%1%2").arg(symbol.name, -10).arg(hexString, -13);
             }
             else {
-                symbolTableLine.append(QString("%1%2").arg(i.key(), -10).arg(hexString, -4));
+                symbolTableLine.append(QString("%1%2").arg(symbol.name, -10).arg(hexString, -4));
                 ui->textEdit->append(symbolTableLine);
                 symbolTableLine = "";
             }
@@ -79,12 +96,104 @@ void AssemblerListingPane::setAssemblerListing(QStringList assemblerListingList)
         }
         ui->textEdit->append("--------------------------------------");
     }
+    if (!annotationList.isEmpty() && !summaryList.isEmpty()) {
+        ui->textEdit->append("");
+        ui->textEdit->append("");
+        ui->textEdit->append(summaryList.join("\n"));
+    }
     ui->textEdit->verticalScrollBar()->setValue(ui->textEdit->verticalScrollBar()->minimum());
 }
 
 void AssemblerListingPane::clearAssemblerListing()
 {
     ui->textEdit->clear();
+    ui->textEdit->setExtraSelections(QList<QTextEdit::ExtraSelection>());
+    crossReferences.clear();
+    listingRowOfLine.clear();
+}
+
+void AssemblerListingPane::setCrossReferences(const Pep::CrossReferenceIndex &index, const QList<int> &rowOfLine)
+{
+    crossReferences = index;
+    listingRowOfLine = rowOfLine;
+}
+
+int AssemblerListingPane::blockOfLine(int lineNum)
+{
+    if (lineNum < 0 || lineNum >= listingRowOfLine.size()) {
+        return -1;
+    }
+    return firstListingBlock + listingRowOfLine.at(lineNum);
+}
+
+int AssemblerListingPane::lineOfBlock(int blockNumber)
+{
+    // The line of a continuation row of .ASCII or .BLOCK is the last line that starts at or before it.
+    QList<int>::const_iterator i = qUpperBound(listingRowOfLine, blockNumber - firstListingBlock);
+    return i == listingRowOfLine.constBegin() ? -1 : (i - listingRowOfLine.constBegin()) - 1;
+}
+
+bool AssemblerListingPane::goToDefinition(QString &symbol)
+{
+    QTextCursor cursor = ui->textEdit->textCursor();
+    symbol = Asm::identifierAt(cursor.block().text(), cursor.positionInBlock());
+    if (!crossReferences.contains(symbol)) {
+        return false;
+    }
+    int blockNumber = blockOfLine(crossReferences.value(symbol).definitionLineNum);
+    if (blockNumber < 0) {
+        return false;
+    }
+    ui->textEdit->setTextCursor(QTextCursor(ui->textEdit->document()->findBlockByNumber(blockNumber)));
+    ui->textEdit->ensureCursorVisible();
+    return true;
+}
+
+int AssemblerListingPane::findReferences(QString &symbol)
+{
+    QTextCursor cursor = ui->textEdit->textCursor();
+    symbol = Asm::identifierAt(cursor.block().text(), cursor.positionInBlock());
+    QList<QTextEdit::ExtraSelection> selections;
+    if (!crossReferences.contains(symbol)) {
+        ui->textEdit->setExtraSelections(selections);
+        return -1;
+    }
+    const Pep::CrossReference &crossReference = crossReferences[symbol];
+    QList<int> lineNums = crossReference.referenceLineNums;
+    if (crossReference.definitionLineNum >= 0) {
+        lineNums.append(crossReference.definitionLineNum);
+    }
+    qSort(lineNums);
+    int cursorLineNum = lineOfBlock(cursor.blockNumber());
+    int nextBlockNumber = -1;
+    for (int i = 0; i < lineNums.size(); i++) {
+        int blockNumber = blockOfLine(lineNums.at(i));
+        if (blockNumber < 0) {
+            continue;
+        }
+        QTextEdit::ExtraSelection selection;
+        selection.cursor = QTextCursor(ui->textEdit->document()->findBlockByNumber(blockNumber));
+        selection.format.setBackground(QColor(255, 255, 200));
+        selection.format.setProperty(QTextFormat::FullWidthSelection, true);
+        selections.append(selection);
+        if (nextBlockNumber < 0 && lineNums.at(i) > cursorLineNum) {
+            nextBlockNumber = blockNumber;
+        }
+    }
+    ui->textEdit->setExtraSelections(selections);
+    if (nextBlockNumber < 0 && !selections.isEmpty()) {
+        nextBlockNumber = selections.first().cursor.blockNumber(); // Wrap around to the first line.
+    }
+    if (nextBlockNumber >= 0) {
+        ui->textEdit->setTextCursor(QTextCursor(ui->textEdit->document()->findBlockByNumber(nextBlockNumber)));
+        ui->textEdit->ensureCursorVisible();
+    }
+    return crossReference.referenceLineNums.size();
+}
+
+Pep::CrossReferenceIndex AssemblerListingPane::getCrossReferenceIndex()
+{
+    return crossReferences;
 }
 
 bool AssemblerListingPane::isModified()
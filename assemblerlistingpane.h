@@ -23,7 +23,9 @@
 #define ASSEMBLERLISTINGPANE_H
 
 #include <QtGui/QWidget>
+#include <QTextEdit>
 #include "pephighlighter.h"
+#include "pep.h"
 #include "enu.h"
 
 namespace Ui {
@@ -36,9 +38,29 @@ class AssemblerListingPane : public QWidget {
 public:
     explicit AssemblerListingPane(QWidget *parent = 0);
     virtual ~AssemblerListingPane();
-    void setAssemblerListing(QStringList assemblerListingList);
+    void setAssemblerListing(QStringList assemblerListingList, QStringList annotationList = QStringList(),
+                             QStringList summaryList = QStringList());
+    // Post: The assembler listing and symbol table are displayed. If annotationList is not empty,
+    // each listing line is prefixed with its annotation, and summaryList follows the symbol table.
     void clearAssemblerListing();
 
+    void setCrossReferences(const Pep::CrossReferenceIndex &index, const QList<int> &rowOfLine);
+    // Pre: The assembler listing of the source program of index is displayed.
+    // Pre: rowOfLine is, for each source line, the listing row at which its listing starts.
+    // Post: Go to definition and find references use index. The index is cleared with the listing.
+
+    bool goToDefinition(QString &symbol);
+    // Post: symbol is the identifier at the cursor. If the cross-reference index has its definition,
+    // the cursor is moved to its listing line and true is returned.
+
+    int findReferences(QString &symbol);
+    // Post: symbol is the identifier at the cursor. If it is in the cross-reference index, the
+    // listing lines that define and use it are highlighted, the cursor is moved to the next of them
+    // after the cursor line, and the number of lines that use it is returned. Otherwise -1 is returned.
+
+    Pep::CrossReferenceIndex getCrossReferenceIndex();
+    // Post: Returns the cross-reference index of the displayed listing.
+
     bool isModified();
     // Post: Returns true if the assembler listing pane has been modified
 
@@ -71,6 +93,17 @@ private:
 
     PepHighlighter *pepHighlighter;
 
+    Pep::CrossReferenceIndex crossReferences;
+    QList<int> listingRowOfLine;
+    int firstListingBlock; // Block of the text edit that holds listing row 0
+
+    int blockOfLine(int lineNum);
+    // Post: Returns the block of the text edit at which the listing of source line lineNum starts,
+    // or -1 if the line is not in the listing.
+
+    int lineOfBlock(int blockNumber);
+    // Post: Returns the source line whose listing includes block blockNumber, or -1 if there is none.
+
     void mouseReleaseEvent(QMouseEvent *);
 
     void mouseDoubleClickEvent(QMouseEvent *);
@@ -0,0 +1,391 @@
+// File: main.cpp
+/*
+    Pep8-1 is a virtual machine for writing machine language and assembly
+    language programs.
+
+    Copyright (C) 2009  J. Stanley Warford, Pepperdine University
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// pep8-bench assembles and runs every program in the figures directory, the OS,
+// and a few generated stress programs, and prints one JSON object per program:
+//   name, kind, sourceLines, bytes      What was measured
+//   assembleMicros                      Mean time for a full assembly
+//   reassembleMicros                    Mean time to reassemble unchanged source with the parse cache
+//   instructions, simMillis,
+//   instructionsPerSecond               Sim::vonNeumannStep loop up to STOP, an error, or maxSteps
+//   operatorNewCalls                    Calls of the global operator new while assembling and running
+//   peakRssKb                           Peak resident set size of the process so far, -1 if unknown
+//   status                              "ok", or the assembler or simulator error
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QStringList>
+#include <QTextStream>
+#include <QTime>
+#include <QAtomicInt>
+#include <cstdlib>
+#include <new>
+#ifdef Q_OS_UNIX
+#include <sys/time.h>
+#include <sys/resource.h>
+#endif
+#include "pep.h"
+#include "sim.h"
+#include "asm.h"
+#include "code.h"
+
+static QBasicAtomicInt newCalls = Q_BASIC_ATOMIC_INITIALIZER(0);
+
+void *operator new(size_t size)
+{
+    newCalls.ref();
+    void *block = std::malloc(size > 0 ? size : 1);
+    if (block == 0) {
+        throw std::bad_alloc();
+    }
+    return block;
+}
+
+void operator delete(void *block) throw()
+{
+    std::free(block);
+}
+
+static const int minTimingMillis = 200; // Assemblies are repeated for at least this long.
+static const int maxSteps = 50000000; // Programs that wait on input forever are cut off here.
+
+// Input for programs that use DECI, CHARI and STRO
+static const QString benchInput = QString("3 17 -42 100 8 255 1 0 x y z\n").repeated(64);
+
+// The installed OS
+static QList<int> osObjectCode;
+static int osRomStartAddress;
+static int osDotBurnArgument;
+
+static long peakRssKb()
+{
+#ifdef Q_OS_UNIX
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef Q_OS_MAC
+    return usage.ru_maxrss / 1024; // Bytes on Mac OS X
+#else
+    return usage.ru_maxrss;
+#endif
+#else
+    return -1;
+#endif
+}
+
+static QString jsonString(QString str)
+{
+    str.replace("\\", "\\\\");
+    str.replace("\"", "\\\"");
+    str.replace("\n", "\\n");
+    return "\"" + str + "\"";
+}
+
+static bool assemble(const QStringList &sourceCodeList, QVector<Asm::ParsedLine> &parsedLines, Enu::EAssembly assembly,
+                     QList<int> &objectCode, QString &errorString)
+// Post: sourceCodeList is assembled by Asm::assembleProgram, as SourceCodePane::assemble does
+// without trace tag processing, and its object code returned in objectCode.
+{
+    QList<Code *> codeList;
+    int lineNum;
+    if (!Asm::assembleProgram(sourceCodeList, parsedLines, codeList, assembly, objectCode, lineNum, errorString)) {
+        errorString = QString("Line %1: %2").arg(lineNum + 1).arg(errorString);
+        return false;
+    }
+    return true;
+}
+
+static bool loadListing(const QString &fileName, int base, QList<int> &objectCode, QString &errorString)
+// Pre: fileName is a .peph (base 16) or .pepb (base 2) machine language listing.
+// Post: The bytes of the listing are returned in objectCode.
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        errorString = "Cannot read " + fileName;
+        return false;
+    }
+    QTextStream in(&file);
+    int digitsPerByte = base == 16 ? 2 : 8;
+    objectCode.clear();
+    while (!in.atEnd()) {
+        QString line = in.readLine();
+        int commentStart = line.indexOf(';');
+        if (commentStart >= 0) {
+            line.truncate(commentStart);
+        }
+        QStringList fields = line.split(' ', QString::SkipEmptyParts);
+        if (fields.size() < 2) {
+            continue;
+        }
+        fields.removeFirst(); // The address
+        QString digits = fields.join("");
+        for (int i = 0; i + digitsPerByte <= digits.length(); i += digitsPerByte) {
+            bool ok;
+            objectCode.append(digits.mid(i, digitsPerByte).toInt(&ok, base));
+            if (!ok) {
+                errorString = "Invalid byte in " + fileName;
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static QString run(const QList<int> &objectCode, int &instructions)
+// Post: objectCode is loaded over the installed OS and run from address 0 with benchInput.
+// Returns "ok" if STOP is reached, otherwise the simulator error or the step limit.
+{
+    for (int i = 0; i < 65536; i++) {
+        Sim::Mem[i] = 0;
+    }
+    for (int i = 0; i < osObjectCode.size(); i++) {
+        Sim::Mem[osRomStartAddress + i] = osObjectCode[i];
+    }
+    Pep::romStartAddress = osRomStartAddress;
+    Pep::dotBurnArgument = osDotBurnArgument;
+    Sim::loadMem(objectCode);
+    Sim::nBit = Sim::zBit = Sim::vBit = Sim::cBit = false;
+    Sim::accumulator = 0;
+    Sim::indexRegister = 0;
+    Sim::stackPointer = Sim::readWord(Pep::dotBurnArgument - 7);
+    Sim::programCounter = 0x0000;
+    Sim::trapped = false;
+    Sim::tracingTraps = false;
+    Sim::setInputDevice(0);
+    Sim::outputDevice = 0;
+    Sim::inputBuffer = benchInput;
+    Sim::outputBuffer = "";
+
+    QString errorString;
+    for (instructions = 0; instructions < maxSteps; instructions++) {
+        if (!Sim::vonNeumannStep(errorString)) {
+            return errorString;
+        }
+        Sim::outputBuffer = "";
+        if (Pep::decodeMnemonic[Sim::instructionSpecifier] == Enu::STOP) {
+            instructions++;
+            return "ok";
+        }
+    }
+    return QString("Stopped after %1 instructions").arg(maxSteps);
+}
+
+static void report(QTextStream &out, const QString &name, const QString &kind, int sourceLines, int bytes,
+                   double assembleMicros, double reassembleMicros, int instructions, int simMillis,
+                   int operatorNewCalls, const QString &status)
+{
+    double instructionsPerSecond = simMillis > 0 ? instructions * 1000.0 / simMillis : 0.0;
+    out << "{\"name\": " << jsonString(name)
+        << ", \"kind\": " << jsonString(kind)
+        << ", \"sourceLines\": " << sourceLines
+        << ", \"bytes\": " << bytes
+        << ", \"assembleMicros\": " << QString::number(assembleMicros, 'f', 1)
+        << ", \"reassembleMicros\": " << QString::number(reassembleMicros, 'f', 1)
+        << ", \"instructions\": " << instructions
+        << ", \"simMillis\": " << simMillis
+        << ", \"instructionsPerSecond\": " << QString::number(instructionsPerSecond, 'f', 0)
+        << ", \"operatorNewCalls\": " << operatorNewCalls
+        << ", \"peakRssKb\": " << peakRssKb()
+        << ", \"status\": " << jsonString(status)
+        << "}\n";
+    out.flush();
+}
+
+static bool benchSource(QTextStream &out, const QString &name, const QString &kind, const QString &source, bool execute)
+// Post: source is assembled repeatedly, reassembled with a warm parse cache, and run if execute is true.
+// Returns false if source does not assemble.
+{
+    QStringList sourceCodeList = source.split('\n');
+    Enu::EAssembly assembly = kind == "os" ? Enu::EOperatingSystem : Enu::EProgram;
+    QList<int> objectCode;
+    QString errorString;
+    int startNewCalls = newCalls;
+
+    QVector<Asm::ParsedLine> parsedLines;
+    QTime timer;
+    int iterations = 0;
+    bool ok;
+    timer.start();
+    do {
+        Asm::clearParsedLines(parsedLines);
+        ok = assemble(sourceCodeList, parsedLines, assembly, objectCode, errorString);
+        iterations++;
+    } while (ok && timer.elapsed() < minTimingMillis);
+    double assembleMicros = timer.elapsed() * 1000.0 / iterations;
+    if (!ok) {
+        Asm::clearParsedLines(parsedLines);
+        report(out, name, kind, sourceCodeList.size(), 0, assembleMicros, 0.0, 0, 0, int(newCalls) - startNewCalls, errorString);
+        return false;
+    }
+
+    iterations = 0;
+    timer.start();
+    do {
+        assemble(sourceCodeList, parsedLines, assembly, objectCode, errorString);
+        iterations++;
+    } while (timer.elapsed() < minTimingMillis);
+    double reassembleMicros = timer.elapsed() * 1000.0 / iterations;
+    Asm::clearParsedLines(parsedLines);
+
+    int instructions = 0;
+    int simMillis = 0;
+    QString status = "ok";
+    if (execute) {
+        timer.start();
+        status = run(objectCode, instructions);
+        simMillis = timer.elapsed();
+    }
+    report(out, name, kind, sourceCodeList.size(), objectCode.size(), assembleMicros, reassembleMicros,
+           instructions, simMillis, int(newCalls) - startNewCalls, status);
+    return true;
+}
+
+static void benchListing(QTextStream &out, const QFileInfo &fileInfo, int base)
+{
+    QList<int> objectCode;
+    QString errorString;
+    int startNewCalls = newCalls;
+    int instructions = 0;
+    int simMillis = 0;
+    QString status;
+    if (loadListing(fileInfo.filePath(), base, objectCode, errorString)) {
+        QTime timer;
+        timer.start();
+        status = run(objectCode, instructions);
+        simMillis = timer.elapsed();
+    }
+    else {
+        status = errorString;
+    }
+    report(out, fileInfo.fileName(), base == 16 ? "hex" : "binary", 0, objectCode.size(), 0.0, 0.0,
+           instructions, simMillis, int(newCalls) - startNewCalls, status);
+}
+
+static QString straightLineProgram(int numLines)
+// Post: Returns numLines lines of unary instructions with a labeled line every 100 lines.
+{
+    static const char *mnemonics[] = { "NOTA", "ASLA", "ASRA", "ROLA", "RORA", "NEGA", "NOTX", "ASLX" };
+    QStringList lines;
+    for (int i = 0; i < numLines; i++) {
+        if (i % 100 == 0) {
+            lines.append(QString("L%1:  %2 ;Block %1").arg(i / 100).arg(mnemonics[i % 8]));
+        }
+        else {
+            lines.append(QString("         %1").arg(mnemonics[i % 8]));
+        }
+    }
+    lines.append("         STOP");
+    lines.append("         .END");
+    return lines.join("\n");
+}
+
+static QString recursionProgram(int depth, int repetitions)
+// Post: Returns a program that recurses depth calls deep, repetitions times.
+{
+    return QString(
+            "         LDX     %1,i\n"
+            "outer:   LDA     %2,i\n"
+            "         CALL    recurse\n"
+            "         SUBX    1,i\n"
+            "         BRNE    outer\n"
+            "         STOP\n"
+            "recurse: CPA     0,i\n"
+            "         BREQ    done\n"
+            "         SUBA    1,i\n"
+            "         CALL    recurse\n"
+            "done:    RET0\n"
+            "         .END\n").arg(repetitions).arg(depth);
+}
+
+static QString loopProgram(int outerCount, int innerCount)
+// Post: Returns a program with a tight loop nested in another.
+{
+    return QString(
+            "         LDX     %1,i\n"
+            "outer:   LDA     %2,i\n"
+            "inner:   SUBA    1,i\n"
+            "         BRNE    inner\n"
+            "         SUBX    1,i\n"
+            "         BRNE    outer\n"
+            "         STOP\n"
+            "         .END\n").arg(outerCount).arg(innerCount);
+}
+
+static QString readFile(const QString &fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return "";
+    }
+    QTextStream in(&file);
+    return in.readAll();
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+    QStringList args = app.arguments();
+    QDir figures(args.size() > 1 ? args.at(1) : "help/figures");
+    if (!figures.exists("pep8os.pep")) {
+        err << "usage: pep8-bench [figures directory containing pep8os.pep]\n";
+        return 1;
+    }
+
+    Pep::initEnumMnemonMaps();
+    Pep::initAddrModesMap();
+    Pep::initMnemonicMaps();
+    Pep::initDecoderTables();
+
+    // The OS
+    QString osSource = readFile(figures.filePath("pep8os.pep"));
+    if (!benchSource(out, "pep8os.pep", "os", osSource, false)) {
+        err << "pep8-bench: the OS does not assemble\n";
+        return 1;
+    }
+    QVector<Asm::ParsedLine> parsedLines;
+    QString errorString;
+    assemble(osSource.split('\n'), parsedLines, Enu::EOperatingSystem, osObjectCode, errorString);
+    Asm::clearParsedLines(parsedLines);
+    osRomStartAddress = Pep::romStartAddress;
+    osDotBurnArgument = Pep::dotBurnArgument;
+
+    // The figures
+    QFileInfoList sources = figures.entryInfoList(QStringList() << "*.pep", QDir::Files, QDir::Name);
+    for (int i = 0; i < sources.size(); i++) {
+        if (sources[i].fileName() != "pep8os.pep") {
+            benchSource(out, sources[i].fileName(), "figure", readFile(sources[i].filePath()), true);
+        }
+    }
+    QFileInfoList listings = figures.entryInfoList(QStringList() << "*.peph" << "*.pepb", QDir::Files, QDir::Name);
+    for (int i = 0; i < listings.size(); i++) {
+        benchListing(out, listings[i], listings[i].suffix() == "peph" ? 16 : 2);
+    }
+
+    // Stress programs
+    benchSource(out, "straight60k", "stress", straightLineProgram(60000), true);
+    benchSource(out, "recursion", "stress", recursionProgram(10000, 50), true);
+    benchSource(out, "loop", "stress", loopProgram(2000, 1000), true);
+
+    return 0;
+}
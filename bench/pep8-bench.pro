@@ -0,0 +1,26 @@
+# #####################################################################
+# pep8-bench: assembler and simulator benchmarks
+# Build with qmake in this directory, then run
+#     ./pep8-bench [figures directory]
+# from the top of the source tree. Results are printed one JSON object per line.
+# #####################################################################
+TEMPLATE = app
+TARGET = pep8-bench
+CONFIG += console
+CONFIG -= app_bundle
+DEPENDPATH += . ..
+INCLUDEPATH += . ..
+
+HEADERS += ../pep.h \
+    ../asm.h \
+    ../code.h \
+    ../argument.h \
+    ../arena.h \
+    ../sim.h \
+    ../enu.h
+SOURCES += main.cpp \
+    ../pep.cpp \
+    ../asm.cpp \
+    ../code.cpp \
+    ../arena.cpp \
+    ../sim.cpp
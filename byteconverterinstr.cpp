@@ -3,6 +3,7 @@
 
 #include "pep.h"
 #include "sim.h"
+#include "disassembler.h"
 
 ByteConverterInstr::ByteConverterInstr(QWidget *parent) :
     QWidget(parent),
@@ -20,8 +21,7 @@ ByteConverterInstr::~ByteConverterInstr()
 
 void ByteConverterInstr::setValue(int data)
 {
-    ui->label->setText(" " + Pep::enumToMnemonMap.value(Pep::decodeMnemonic[data])
-                       + Pep::commaSpaceToAddrMode(Pep::decodeAddrMode[data]));
+    ui->label->setText(" " + Disassembler::instructionString(data));
 }
 
 void ByteConverterInstr::changeEvent(QEvent *e)
@@ -25,6 +25,48 @@
 #include <QRegExp>
 #include <QDebug>
 
+// Destructors
+// Each code object owns its argument.
+NonUnaryInstruction::~NonUnaryInstruction()
+{
+    delete argument;
+}
+
+DotAddrss::~DotAddrss()
+{
+    delete argument;
+}
+
+DotAscii::~DotAscii()
+{
+    delete argument;
+}
+
+DotBlock::~DotBlock()
+{
+    delete argument;
+}
+
+DotBurn::~DotBurn()
+{
+    delete argument;
+}
+
+DotByte::~DotByte()
+{
+    delete argument;
+}
+
+DotEquate::~DotEquate()
+{
+    delete argument;
+}
+
+DotWord::~DotWord()
+{
+    delete argument;
+}
+
 // appendObjectCode
 void UnaryInstruction::appendObjectCode(QList<int> &objectCode)
 {
@@ -53,7 +95,7 @@ void NonUnaryInstruction::appendObjectCode(QList<int> &objectCode)
 void DotAddrss::appendObjectCode(QList<int> &objectCode)
 {
     if ((Pep::burnCount == 0) || ((Pep::burnCount == 1) && (memAddress >= Pep::romStartAddress))) {
-        int symbolValue = Pep::symbolTable.value(argument->getArgumentString());
+        int symbolValue = argument->getArgumentValue();
         objectCode.append(symbolValue / 256);
         objectCode.append(symbolValue % 256);
     }
@@ -189,7 +231,7 @@ void NonUnaryInstruction::appendSourceLine(QStringList &assemblerListingList, QS
 void DotAddrss::appendSourceLine(QStringList &assemblerListingList, QStringList &listingTraceList, QList<bool> &hasCheckBox)
 {
     QString memStr = QString("%1").arg(memAddress, 4, 16, QLatin1Char('0')).toUpper();
-    int symbolValue = Pep::symbolTable.value(argument->getArgumentString());
+    int symbolValue = argument->getArgumentValue();
     QString codeStr = QString("%1").arg(symbolValue, 4, 16, QLatin1Char('0')).toUpper();
     if ((Pep::burnCount == 1) && (memAddress < Pep::romStartAddress)) {
         codeStr = "    ";
@@ -438,9 +480,11 @@ bool DotBlock::processFormatTraceTags(int &sourceLine, QString &errorString) {
             sourceLine = sourceCodeLine;
             return false;
         }
-        Pep::symbolFormat.insert(symbolDef, tagType);
-        Pep::symbolFormatMultiplier.insert(symbolDef, multiplier);
-        Pep::blockSymbols.append(symbolDef);
+        int id = Pep::symbolId(symbolDef);
+        Pep::symbols[id].format = tagType;
+        Pep::symbols[id].formatMultiplier = multiplier;
+        Pep::symbols[id].isBlockSymbol = true;
+        Pep::blockSymbols.append(id);
     }
     return true;
 }
@@ -452,9 +496,11 @@ bool DotEquate::processFormatTraceTags(int &, QString &) {
     int pos = Asm::rxFormatTag.indexIn(comment);
     if (pos > -1) {
         QString formatTag = Asm::rxFormatTag.cap(0);
-        Pep::symbolFormat.insert(symbolDef, Asm::formatTagType(formatTag));
-        Pep::symbolFormatMultiplier.insert(symbolDef, Asm::formatMultiplier(formatTag));
-        Pep::equateSymbols.append(symbolDef);
+        int id = Pep::symbolId(symbolDef);
+        Pep::symbols[id].format = Asm::formatTagType(formatTag);
+        Pep::symbols[id].formatMultiplier = Asm::formatMultiplier(formatTag);
+        Pep::symbols[id].isEquateSymbol = true;
+        Pep::equateSymbols.append(id);
     }
     return true;
 }
@@ -464,22 +510,24 @@ bool DotBlock::processSymbolTraceTags(int &sourceLine, QString &errorString) {
     if (symbolDef.size() == 0) {
         return true;
     }
-    if (Pep::blockSymbols.contains(symbolDef)) {
+    if (Pep::symbols.at(Pep::symbolId(symbolDef)).isBlockSymbol) {
         return true; // Format tag takes precedence over symbol tags.
     }
     int numBytesAllocated = argument->getArgumentValue();
     QString symbol;
+    int id;
     QStringList list;
     int numBytesListed = 0;
     int pos = 0;
     while ((pos = Asm::rxSymbolTag.indexIn(comment, pos)) != -1) {
         symbol = Asm::rxSymbolTag.cap(1);
-        if (!Pep::equateSymbols.contains(symbol)) {
+        id = Pep::symbolId(symbol);
+        if (id < 0 || !Pep::symbols.at(id).isEquateSymbol) {
             errorString = ";WARNING: " + symbol + " not specified in .EQUATE.";
             sourceLine = sourceCodeLine;
             return false;
         }
-        numBytesListed += Asm::tagNumBytes(Pep::symbolFormat.value(symbol)) * Pep::symbolFormatMultiplier.value(symbol);
+        numBytesListed += Asm::tagNumBytes(Pep::symbols.at(id).format) * Pep::symbols.at(id).formatMultiplier;
         list.append(symbol);
         pos += Asm::rxSymbolTag.matchedLength();
     }
@@ -489,7 +537,9 @@ bool DotBlock::processSymbolTraceTags(int &sourceLine, QString &errorString) {
         sourceLine = sourceCodeLine;
         return false;
     }
-    Pep::blockSymbols.append(symbolDef);
+    int symbolDefId = Pep::symbolId(symbolDef);
+    Pep::symbols[symbolDefId].isBlockSymbol = true;
+    Pep::blockSymbols.append(symbolDefId);
     Pep::globalStructSymbols.insert(symbolDef, list);
     return true;
 }
@@ -522,17 +572,19 @@ bool UnaryInstruction::processSymbolTraceTags(int &sourceLine, QString &errorStr
         return true;
     }
     QString symbol;
+    int id;
     QStringList list;
     int numBytesListed = 0;
     int pos = 0;
     while ((pos = Asm::rxSymbolTag.indexIn(comment, pos)) != -1) {
         symbol = Asm::rxSymbolTag.cap(1);
-        if (!Pep::equateSymbols.contains(symbol)) {
+        id = Pep::symbolId(symbol);
+        if (id < 0 || !Pep::symbols.at(id).isEquateSymbol) {
             errorString = ";WARNING: " + symbol + " not specified in .EQUATE.";
             sourceLine = sourceCodeLine;
             return false;
         }
-        numBytesListed += Asm::tagNumBytes(Pep::symbolFormat.value(symbol)) * Pep::symbolFormatMultiplier.value(symbol);
+        numBytesListed += Asm::tagNumBytes(Pep::symbols.at(id).format) * Pep::symbols.at(id).formatMultiplier;
         list.append(symbol);
         pos += Asm::rxSymbolTag.matchedLength();
     }
@@ -556,17 +608,19 @@ bool NonUnaryInstruction::processSymbolTraceTags(int &sourceLine, QString &error
         }
         numBytesAllocated = argument->getArgumentValue();
         QString symbol;
+        int id;
         QStringList list;
         int numBytesListed = 0;
         int pos = 0;
         while ((pos = Asm::rxSymbolTag.indexIn(comment, pos)) != -1) {
             symbol = Asm::rxSymbolTag.cap(1);
-            if (!Pep::equateSymbols.contains(symbol)) {
+            id = Pep::symbolId(symbol);
+            if (id < 0 || !Pep::symbols.at(id).isEquateSymbol) {
                 errorString = ";WARNING: " + symbol + " not specified in .EQUATE.";
                 sourceLine = sourceCodeLine;
                 return false;
             }
-            numBytesListed += Asm::tagNumBytes(Pep::symbolFormat.value(symbol)) * Pep::symbolFormatMultiplier.value(symbol);
+            numBytesListed += Asm::tagNumBytes(Pep::symbols.at(id).format) * Pep::symbols.at(id).formatMultiplier;
             list.append(symbol);
             pos += Asm::rxSymbolTag.matchedLength();
         }
@@ -586,7 +640,8 @@ bool NonUnaryInstruction::processSymbolTraceTags(int &sourceLine, QString &error
         QStringList list;
         while ((pos = Asm::rxSymbolTag.indexIn(comment, pos)) != -1) {
             symbol = Asm::rxSymbolTag.cap(1);
-            if (!Pep::equateSymbols.contains(symbol) && !Pep::blockSymbols.contains(symbol)) {
+            int id = Pep::symbolId(symbol);
+            if (id < 0 || (!Pep::symbols.at(id).isEquateSymbol && !Pep::symbols.at(id).isBlockSymbol)) {
                 errorString = ";WARNING: " + symbol + " not specified in .EQUATE.";
                 sourceLine = sourceCodeLine;
                 return false;
@@ -601,3 +656,19 @@ bool NonUnaryInstruction::processSymbolTraceTags(int &sourceLine, QString &error
         return true;
     }
 }
+
+// getSymbolOperand
+bool NonUnaryInstruction::getSymbolOperand(int &address, QString &symbol) {
+    if (!argument->isSymbolRef()) {
+        return false;
+    }
+    address = memAddress + 1;
+    symbol = argument->getArgumentString();
+    return true;
+}
+
+bool DotAddrss::getSymbolOperand(int &address, QString &symbol) {
+    address = memAddress;
+    symbol = argument->getArgumentString();
+    return true;
+}
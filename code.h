@@ -24,6 +24,7 @@
 
 #include "pep.h"
 #include "enu.h"
+#include "arena.h"
 
 class Argument; // Forward declaration for attributes of code classes.
 
@@ -31,13 +32,20 @@ class Argument; // Forward declaration for attributes of code classes.
 class Code
 {
     friend class Asm;
+    friend class Peephole;
+    friend class FlowGraph;
 public:
     virtual ~Code() { }
+    static void *operator new(size_t size) { return Arena::allocate(size); }
+    static void operator delete(void *block, size_t size) { Arena::release(block, size); }
     virtual void appendObjectCode(QList<int> &objectCode) = 0;
     virtual void appendSourceLine(QStringList &assemblerListingList, QStringList &listingTraceList, QList<bool> &hasCheckBox) = 0;
     void adjustMemAddress(int addressDelta) { memAddress += addressDelta; }
     virtual bool processFormatTraceTags(int &, QString &) { return true; }
     virtual bool processSymbolTraceTags(int &, QString &) { return true; }
+    virtual bool getSymbolOperand(int &, QString &) { return false; }
+    // Post: If the object code holds the value of a symbol, true is returned, the first
+    // argument is the address of the word and the second is the symbol.
 
 protected:
     int memAddress;
@@ -50,6 +58,8 @@ protected:
 class UnaryInstruction: public Code
 {
     friend class Asm;
+    friend class Peephole;
+    friend class FlowGraph;
 private:
     Enu::EMnemonic mnemonic;
 public:
@@ -61,15 +71,19 @@ public:
 class NonUnaryInstruction: public Code
 {
     friend class Asm;
+    friend class Peephole;
+    friend class FlowGraph;
 private:
     Enu::EMnemonic mnemonic;
     Enu::EAddrMode addressingMode;
     Argument *argument;
 public:
-    // ~NonUnaryInstruction() { delete argument; }
+    NonUnaryInstruction() { argument = NULL; }
+    ~NonUnaryInstruction();
     void appendObjectCode(QList<int> &objectCode);
     void appendSourceLine(QStringList &assemblerListingList, QStringList &listingTraceList, QList<bool> &hasCheckBox);
     bool processSymbolTraceTags(int &sourceLine, QString &errorString);
+    bool getSymbolOperand(int &address, QString &symbol);
 };
 
 class DotAddrss: public Code
@@ -78,8 +92,11 @@ class DotAddrss: public Code
 private:
     Argument *argument;
 public:
+    DotAddrss() { argument = NULL; }
+    ~DotAddrss();
     void appendObjectCode(QList<int> &objectCode);
     void appendSourceLine(QStringList &assemblerListingList, QStringList &listingTraceList, QList<bool> &hasCheckBox);
+    bool getSymbolOperand(int &address, QString &symbol);
 };
 
 class DotAscii: public Code
@@ -88,6 +105,8 @@ class DotAscii: public Code
 private:
     Argument *argument;
 public:
+    DotAscii() { argument = NULL; }
+    ~DotAscii();
     void appendObjectCode(QList<int> &objectCode);
     void appendSourceLine(QStringList &assemblerListingList, QStringList &listingTraceList, QList<bool> &hasCheckBox);
 };
@@ -98,6 +117,8 @@ class DotBlock: public Code
 private:
     Argument *argument;
 public:
+    DotBlock() { argument = NULL; }
+    ~DotBlock();
     void appendObjectCode(QList<int> &objectCode);
     void appendSourceLine(QStringList &assemblerListingList, QStringList &listingTraceList, QList<bool> &hasCheckBox);
     bool processFormatTraceTags(int &sourceLine, QString &errorString);
@@ -110,6 +131,8 @@ class DotBurn: public Code
 private:
     Argument *argument;
 public:
+    DotBurn() { argument = NULL; }
+    ~DotBurn();
     void appendObjectCode(QList<int> &objectCode);
     void appendSourceLine(QStringList &assemblerListingList, QStringList &listingTraceList, QList<bool> &hasCheckBox);
 };
@@ -120,6 +143,8 @@ class DotByte: public Code
 private:
     Argument *argument;
 public:
+    DotByte() { argument = NULL; }
+    ~DotByte();
     void appendObjectCode(QList<int> &objectCode);
     void appendSourceLine(QStringList &assemblerListingList, QStringList &listingTraceList, QList<bool> &hasCheckBox);
 };
@@ -138,6 +163,8 @@ class DotEquate: public Code
 private:
     Argument *argument;
 public:
+    DotEquate() { argument = NULL; }
+    ~DotEquate();
     void appendObjectCode(QList<int> &objectCode);
     void appendSourceLine(QStringList &assemblerListingList, QStringList &listingTraceList, QList<bool> &hasCheckBox);
     bool processFormatTraceTags(int &sourceLine, QString &errorString);
@@ -146,9 +173,12 @@ public:
 class DotWord: public Code
 {
     friend class Asm;
+    friend class Peephole;
 private:
     Argument *argument;
 public:
+    DotWord() { argument = NULL; }
+    ~DotWord();
     void appendObjectCode(QList<int> &objectCode);
     void appendSourceLine(QStringList &assemblerListingList, QStringList &listingTraceList, QList<bool> &hasCheckBox);
 };
@@ -21,7 +21,7 @@
 #include "cpphighlighter.h"
 
 CppHighlighter::CppHighlighter(QTextDocument *parent)
-    : QSyntaxHighlighter(parent)
+    : IncrementalHighlighter(parent)
 {
     HighlightingRule rule;
 
@@ -35,27 +35,16 @@ CppHighlighter::CppHighlighter(QTextDocument *parent)
 
     declarationFormat.setFontItalic(true);
     declarationFormat.setForeground(Qt::darkBlue);
-    QStringList declarationPatterns;
-    declarationPatterns << "\\bbool\\b" << "\\bchar\\b" << "\\bconst\\b" << "\\bcase\\b"
-                    << "\\benum\\b" << "\\bint\\b" << "\\bnamespace\\b" << "\\bstruct\\b"
-                    << "\\busing\\b" << "\\#include\\b" << "\\bvoid\\b";
-    foreach (const QString &pattern, declarationPatterns) {
-        rule.pattern = QRegExp(pattern);
-        rule.format = declarationFormat;
-        highlightingRules.append(rule);
-    }
+    // One alternation per format, so that a line is scanned once per format rather than once per word.
+    rule.pattern = QRegExp("\\b(bool|char|const|case|enum|int|namespace|struct|using|void)\\b|\\#include\\b");
+    rule.format = declarationFormat;
+    highlightingRules.append(rule);
 
     keywordFormat.setForeground(Qt::darkBlue);
     keywordFormat.setFontWeight(QFont::Bold);
-    QStringList keywordPatterns;
-    keywordPatterns << "\\bwhile\\b" << "\\bfor\\b" << "\\bswitch\\b"
-            << "\\bif\\b" << "\\bdo\\b" << "\\bnew\\b"
-            << "\\breturn\\b" << "\\belse\\b";
-    foreach (const QString &pattern, keywordPatterns) {
-        rule.pattern = QRegExp(pattern);
-        rule.format = keywordFormat;
-        highlightingRules.append(rule);
-    }
+    rule.pattern = QRegExp("\\b(while|for|switch|if|do|new|return|else)\\b");
+    rule.format = keywordFormat;
+    highlightingRules.append(rule);
 
     classFormat.setFontWeight(QFont::Bold);
     classFormat.setForeground(Qt::darkMagenta);
@@ -84,14 +73,17 @@ CppHighlighter::CppHighlighter(QTextDocument *parent)
     commentEndExpression = QRegExp("\\*/");
 }
 
-void CppHighlighter::highlightBlock(const QString &text)
+void CppHighlighter::highlightLine(const QString &text)
 {
-    foreach (const HighlightingRule &rule, highlightingRules) {
-        QRegExp expression(rule.pattern);
+    // The patterns are compiled once in the constructor and matched in place; indexIn only
+    // updates their match state.
+    for (int i = 0; i < highlightingRules.size(); i++) {
+        QRegExp &expression = highlightingRules[i].pattern;
+        const QTextCharFormat &format = highlightingRules[i].format;
         int index = expression.indexIn(text);
         while (index >= 0) {
             int length = expression.matchedLength();
-            setFormat(index, length, rule.format);
+            setFormat(index, length, format);
             index = expression.indexIn(text, index + length);
         }
     }
@@ -22,7 +22,7 @@
 #ifndef CPPHIGHLIGHTER_H
 #define CPPHIGHLIGHTER_H
 
-#include <QSyntaxHighlighter>
+#include "incrementalhighlighter.h"
 
 #include <QHash>
 #include <QTextCharFormat>
@@ -31,13 +31,13 @@ QT_BEGIN_NAMESPACE
 class QTextDocument;
 QT_END_NAMESPACE
 
-class CppHighlighter : public QSyntaxHighlighter
+class CppHighlighter : public IncrementalHighlighter
 {
 public:
     CppHighlighter(QTextDocument *parent = 0);
 
 protected:
-    void highlightBlock(const QString &text);
+    void highlightLine(const QString &text);
 
 private:
     struct HighlightingRule
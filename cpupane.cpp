@@ -21,10 +21,12 @@
 #include <QMessageBox>
 #include <QKeyEvent>
 #include <QSound>
+#include <QSet>
 #include "cpupane.h"
 #include "ui_cpupane.h"
 #include "sim.h"
 #include "pep.h"
+#include "disassembler.h"
 #include <QtGlobal>
 
 CpuPane::CpuPane(QWidget *parent) :
@@ -37,6 +39,9 @@ CpuPane::CpuPane(QWidget *parent) :
     connect(ui->resumePushButton, SIGNAL(clicked()), this, SIGNAL(resumeButtonClicked()));
 
     interruptExecutionFlag = false;
+    stepsSinceEvents = 0;
+    nativeLoaderEnabled = true;
+    clearTemporaryBreakpoint();
     clearCpu();
     
     if (Pep::getSystem() != "Mac") {
@@ -311,8 +316,15 @@ void CpuPane::resumeWithBatch()
     isCurrentlySimulating = true;
     interruptExecutionFlag = false;
     QString errorString;
+    // The loader is interpreted when it is being debugged or stepped over
+    bool nativeLoader = nativeLoaderEnabled && !Pep::listingRowCheckedOS.values().contains(Qt::Checked) &&
+            temporaryBreakpoint < 0 && stepOutCallDepth < 0;
     while (true) {
-        qApp->processEvents(); // To make sure that the event filter gets to handle keypresses during the run
+        processEventsPeriodically(); // To make sure that the event filter gets to handle keypresses during the run
+        if (nativeLoader && Pep::decodeMnemonic[Sim::readByte(Sim::programCounter)] == Enu::CHARI &&
+            Sim::runNativeLoader() > 0) {
+            emit vonNeumannStepped();
+        }
         if (ui->traceTrapsCheckBox->isChecked()) {
             trapLookahead();
         }
@@ -334,10 +346,17 @@ void CpuPane::resumeWithBatch()
                 isCurrentlySimulating = false;
                 return;
             }
+            if (temporaryBreakpointReached()) {
+                updateCpu();
+                emit updateSimulationView();
+                isCurrentlySimulating = false;
+                return;
+            }
             if (Pep::memAddrssToAssemblerListing->contains(Sim::programCounter) &&
                 Pep::listingRowChecked->value(Pep::memAddrssToAssemblerListing->value(Sim::programCounter)) == Qt::Checked) {
                 updateCpu();
                 emit updateSimulationView();
+                isCurrentlySimulating = false;
                 return;
             }
         }
@@ -363,13 +382,13 @@ void CpuPane::resumeWithTerminal()
     interruptExecutionFlag = false;
     QString errorString;
     while (true) {
-        qApp->processEvents(); // To make sure that the event filter gets to handle keypresses during the run
+        processEventsPeriodically(); // To make sure that the event filter gets to handle keypresses during the run
         trapLookahead();
         if (Sim::trapped && !ui->traceTrapsCheckBox->isChecked()) {
             updateCpu();
             do {
                 trapLookahead();
-                qApp->processEvents(); // To make sure that the event filter gets to handle keypresses during the run
+                processEventsPeriodically(); // To make sure that the event filter gets to handle keypresses during the run
                 if ((Pep::decodeMnemonic[Sim::readByte(Sim::programCounter)] == Enu::CHARI) && Sim::inputBuffer.isEmpty()) {
                     // we are waiting for input
                     ui->singleStepPushButton->setDisabled(true);
@@ -389,6 +408,12 @@ void CpuPane::resumeWithTerminal()
                             emit updateSimulationView();
                             emit executionComplete();
                         }
+                        else if (temporaryBreakpointReached()) {
+                            updateCpu();
+                            emit updateSimulationView();
+                            isCurrentlySimulating = false;
+                            return;
+                        }
                     }
                     else {
                         QMessageBox::warning(0, "Pep/8", errorString);
@@ -428,6 +453,12 @@ void CpuPane::resumeWithTerminal()
                     isCurrentlySimulating = false;
                     return;
                 }
+                if (temporaryBreakpointReached()) {
+                    updateCpu();
+                    emit updateSimulationView();
+                    isCurrentlySimulating = false;
+                    return;
+                }
                 if (Pep::memAddrssToAssemblerListing->contains(Sim::programCounter) &&
                     Pep::listingRowChecked->value(Pep::memAddrssToAssemblerListing->value(Sim::programCounter)) == Qt::Checked) {
                     updateCpu();
@@ -459,37 +490,19 @@ void CpuPane::singleStepWithBatch()
     QString errorString;
     trapLookahead();
     if (Sim::trapped && !ui->traceTrapsCheckBox->isChecked()) {
-        QString errorString;
-        do {
-            trapLookahead();
-            qApp->processEvents();
-            if (Sim::vonNeumannStep(errorString)) {
-                emit vonNeumannStepped();
-                if (Sim::outputBuffer.length() == 1) {
-                    emit appendOutput(Sim::outputBuffer);
-                    Sim::outputBuffer = "";
-                }
-                if (Pep::decodeMnemonic[Sim::instructionSpecifier] == Enu::STOP) {
-                    emit updateSimulationView();
-                    emit executionComplete();
-                    isCurrentlySimulating = false;
-                }
-            }
-            else {
-                QMessageBox::warning(0, "Pep/8", errorString);
-                emit updateSimulationView();
-                emit executionComplete();
-                isCurrentlySimulating = false;
-            }
-            if (interruptExecutionFlag) {
-                updateCpu();
-                emit updateSimulationView();
-                isCurrentlySimulating = false;
-                return;
-            }
-        } while (Sim::trapped);
-        emit updateSimulationView();
-        updateCpu();
+        if (!runTrap(errorString, false)) {
+            QMessageBox::warning(0, "Pep/8", errorString);
+            emit updateSimulationView();
+            emit executionComplete();
+        }
+        else if (Pep::decodeMnemonic[Sim::instructionSpecifier] == Enu::STOP) {
+            emit updateSimulationView();
+            emit executionComplete();
+        }
+        else {
+            emit updateSimulationView();
+            updateCpu();
+        }
     }
     else if (Sim::vonNeumannStep(errorString)) {
         emit vonNeumannStepped();
@@ -522,45 +535,27 @@ void CpuPane::singleStepWithTerminal()
     trapLookahead();
     if (Sim::trapped && !ui->traceTrapsCheckBox->isChecked()) {
         updateCpu();
-        do {
-            trapLookahead();
-            qApp->processEvents();
-            if ((Pep::decodeMnemonic[Sim::readByte(Sim::programCounter)] == Enu::CHARI) && Sim::inputBuffer.isEmpty()) {
-                // we are waiting for input
-                ui->singleStepPushButton->setDisabled(true);
-                ui->resumePushButton->setDisabled(true);
-                emit waitingForInput();
-                isCurrentlySimulating = false;
-                return;
-            }
-            else {
-                if (Sim::vonNeumannStep(errorString)) {
-                    emit vonNeumannStepped();
-                    if (Sim::outputBuffer.length() == 1) {
-                        emit appendOutput(Sim::outputBuffer);
-                        Sim::outputBuffer = "";
-                    }
-                    if (Pep::decodeMnemonic[Sim::instructionSpecifier] == Enu::STOP) {
-                        emit updateSimulationView();
-                        emit executionComplete();
-                        isCurrentlySimulating = false;
-                    }
-                }
-                else {
-                    QMessageBox::warning(0, "Pep/8", errorString);
-                    emit updateSimulationView();
-                    emit executionComplete();
-                    isCurrentlySimulating = false;
-                }
-            }
-            if (interruptExecutionFlag) {
-                updateCpu();
-                emit updateSimulationView();
-                isCurrentlySimulating = false;
-                return;
-            }
-        } while (Sim::trapped);
-        emit updateSimulationView();
+        if (!runTrap(errorString, true)) {
+            QMessageBox::warning(0, "Pep/8", errorString);
+            emit updateSimulationView();
+            emit executionComplete();
+        }
+        else if (Pep::decodeMnemonic[Sim::instructionSpecifier] == Enu::STOP) {
+            emit updateSimulationView();
+            emit executionComplete();
+        }
+        else if (Sim::trapped && !interruptExecutionFlag) {
+            // we are waiting for input
+            ui->singleStepPushButton->setDisabled(true);
+            ui->resumePushButton->setDisabled(true);
+            emit waitingForInput();
+            isCurrentlySimulating = false;
+            return;
+        }
+        else {
+            updateCpu();
+            emit updateSimulationView();
+        }
     }
     else if ((Pep::decodeMnemonic[Sim::readByte(Sim::programCounter)] == Enu::CHARI) && Sim::inputBuffer.isEmpty()) {
         ui->singleStepPushButton->setDisabled(true);
@@ -598,6 +593,39 @@ void CpuPane::singleStepWithTerminal()
     isCurrentlySimulating = false;
 }
 
+bool CpuPane::runTrap(QString &errorString, bool stopForInput)
+{
+    QSet<int> trapModifiedBytes;
+    QString trapOutput;
+    bool ok;
+    bool trapFinished;
+    do {
+        ok = Sim::runTrap(errorString, trapInstructionsPerCall, stopForInput);
+        trapModifiedBytes.unite(Sim::modifiedBytes);
+        trapOutput.append(Sim::outputBuffer);
+        Enu::EMnemonic mnemonic = Pep::decodeMnemonic[Sim::instructionSpecifier];
+        trapFinished = mnemonic == Enu::RETTR || mnemonic == Enu::STOP ||
+                       (stopForInput && Pep::decodeMnemonic[Sim::readByte(Sim::programCounter)] == Enu::CHARI &&
+                        Sim::inputBuffer.isEmpty());
+        if (!trapFinished) {
+            qApp->processEvents(); // A trap handler that never returns can still be interrupted
+        }
+    } while (ok && !trapFinished && !interruptExecutionFlag);
+
+    Sim::modifiedBytes = trapModifiedBytes;
+    if (Pep::decodeMnemonic[Sim::instructionSpecifier] == Enu::RETTR) {
+        Sim::trapped = false;
+        Pep::memAddrssToAssemblerListing = &Pep::memAddrssToAssemblerListingProg;
+        Pep::listingRowChecked = &Pep::listingRowCheckedProg;
+    }
+    emit vonNeumannStepped();
+    Sim::outputBuffer = "";
+    if (!trapOutput.isEmpty()) {
+        emit appendOutput(trapOutput);
+    }
+    return ok;
+}
+
 void CpuPane::trapLookahead()
 {
     if (Pep::isTrapMap[Pep::decodeMnemonic[Sim::readByte(Sim::programCounter)]]) {
@@ -617,6 +645,76 @@ void CpuPane::interruptExecution()
     interruptExecutionFlag = true;
 }
 
+bool CpuPane::setStepOverBreakpoint()
+{
+    int instructionSpecifier = Sim::readByte(Sim::programCounter);
+    Enu::EMnemonic mnemonic = Pep::decodeMnemonic[instructionSpecifier];
+    if (mnemonic != Enu::CALL && !Pep::isTrapMap[mnemonic]) {
+        return false;
+    }
+    clearTemporaryBreakpoint();
+    temporaryBreakpoint = (Sim::programCounter + Disassembler::instructionLength(instructionSpecifier)) & 0xffff;
+    // A recursive call reaches the same address deeper in the stack, so it must not stop there.
+    temporaryBreakpointStackPointer = Sim::stackPointer;
+    return true;
+}
+
+void CpuPane::setStepOutBreakpoint()
+{
+    clearTemporaryBreakpoint();
+    stepOutCallDepth = 0;
+}
+
+void CpuPane::setRunToCursorBreakpoint(int address)
+{
+    clearTemporaryBreakpoint();
+    temporaryBreakpoint = address;
+}
+
+void CpuPane::setNativeLoaderEnabled(bool b)
+{
+    nativeLoaderEnabled = b;
+}
+
+void CpuPane::clearTemporaryBreakpoint()
+{
+    temporaryBreakpoint = -1;
+    temporaryBreakpointStackPointer = 0;
+    stepOutCallDepth = -1;
+}
+
+bool CpuPane::temporaryBreakpointReached()
+{
+    if (stepOutCallDepth >= 0) {
+        // The first return that matches no call made since Step Out began leaves the current routine.
+        Enu::EMnemonic mnemonic = Pep::decodeMnemonic[Sim::instructionSpecifier];
+        if (mnemonic == Enu::CALL || Pep::isTrapMap[mnemonic]) {
+            stepOutCallDepth++;
+        }
+        else if (mnemonic >= Enu::RET0 && mnemonic <= Enu::RETTR) {
+            if (stepOutCallDepth == 0) {
+                clearTemporaryBreakpoint();
+                return true;
+            }
+            stepOutCallDepth--;
+        }
+        return false;
+    }
+    if (Sim::programCounter == temporaryBreakpoint && Sim::stackPointer >= temporaryBreakpointStackPointer) {
+        clearTemporaryBreakpoint();
+        return true;
+    }
+    return false;
+}
+
+void CpuPane::processEventsPeriodically()
+{
+    if (++stepsSinceEvents >= eventInterval) {
+        stepsSinceEvents = 0;
+        qApp->processEvents();
+    }
+}
+
 void CpuPane::highlightOnFocus()
 {
     if (ui->singleStepPushButton->hasFocus()) {
@@ -78,6 +78,24 @@ public:
     void interruptExecution();
     // Post: interruptExecutionFlag is set to true
 
+    bool setStepOverBreakpoint();
+    // Post: If the instruction at the program counter is a CALL or a trap, a temporary breakpoint
+    // is set on the instruction that follows it and true is returned. Otherwise false is returned.
+
+    void setStepOutBreakpoint();
+    // Post: A temporary breakpoint is set after the RETn or RETTR that returns from the current
+    // subroutine or trap handler
+
+    void setRunToCursorBreakpoint(int address);
+    // Post: A temporary breakpoint is set at address
+
+    void clearTemporaryBreakpoint();
+    // Post: The temporary breakpoint of Step Over, Step Out or Run to Cursor is removed
+
+    void setNativeLoaderEnabled(bool b);
+    // Post: If b, resuming through the system loader stores the object code natively instead
+    // of interpreting the loader, unless a break point is set in the OS
+
     void highlightOnFocus();
     // Post: Highlights the label based on the label window color saved in the UI file
 
@@ -104,6 +122,31 @@ private:
 
     bool interruptExecutionFlag; // Used to interrupt execution by the user
 
+    int temporaryBreakpoint; // Address of the Step Over or Run to Cursor breakpoint, -1 if none
+    int temporaryBreakpointStackPointer; // Step Over stops only when SP is back at or above this
+    int stepOutCallDepth; // Calls and traps entered since Step Out began, -1 if not stepping out
+
+    bool nativeLoaderEnabled;
+
+    int stepsSinceEvents; // Resume only processes events every eventInterval instructions
+    static const int eventInterval = 256;
+
+    bool temporaryBreakpointReached();
+    // Pre: Sim::instructionSpecifier is the instruction just executed
+    // Post: Returns true, and clears the temporary breakpoint, if execution stops there
+
+    void processEventsPeriodically();
+    // Post: Pending events are handled if eventInterval instructions ran since they last were
+
+    static const int trapInstructionsPerCall = 4096;
+
+    bool runTrap(QString &errorString, bool stopForInput);
+    // Pre: Sim::trapped, and the trap instruction or its handler is next to execute
+    // Post: The trap runs through RETTR without painting, stopping early at STOP, an error, an
+    // interrupt or, if stopForInput, a CHARI with no input. The memory panes are sent the bytes
+    // written by the whole trap in a single vonNeumannStepped, and its output in a single appendOutput.
+    // Returns false with errorString set if an instruction fails.
+
     Enu::EWaiting waiting; // Used to store terminal IO waiting for input state
 
     void mousePressEvent(QMouseEvent *);
@@ -0,0 +1,236 @@
+// File: disassembler.cpp
+/*
+    Pep8-1 is a virtual machine for writing machine language and assembly
+    language programs.
+    
+    Copyright (C) 2009  J. Stanley Warford, Pepperdine University
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "disassembler.h"
+#include "flowgraph.h"
+#include "pep.h"
+#include "sim.h"
+
+using namespace Enu;
+
+static const int memorySize = 65536;
+
+// Data is listed as a hex .WORD per row, or a .BYTE for a lone last byte
+static const int dataBytesPerRow = 2;
+
+Disassembler::Disassembler()
+    : isCode(memorySize), isInstructionStart(memorySize)
+{
+    entryAddress = 0;
+    firstAddress = 0;
+    endAddress = 0;
+    outOfDate = false;
+}
+
+QString Disassembler::instructionString(int instructionSpecifier)
+{
+    return Pep::enumToMnemonMap.value(Pep::decodeMnemonic[instructionSpecifier])
+            + Pep::commaSpaceToAddrMode(Pep::decodeAddrMode[instructionSpecifier]);
+}
+
+int Disassembler::instructionLength(int instructionSpecifier)
+{
+    return Pep::isUnaryMap.value(Pep::decodeMnemonic[instructionSpecifier]) ? 1 : 3;
+}
+
+bool Disassembler::isValidInstruction(int instructionSpecifier)
+{
+    EMnemonic mnemonic = Pep::decodeMnemonic[instructionSpecifier];
+    if (Pep::isUnaryMap.value(mnemonic)) {
+        return true;
+    }
+    return (Pep::addrModesMap.value(mnemonic) & Pep::decodeAddrMode[instructionSpecifier]) != 0;
+}
+
+void Disassembler::disassemble(int entryAddress, int firstAddress, int endAddress)
+{
+    this->entryAddress = entryAddress;
+    this->firstAddress = firstAddress;
+    this->endAddress = endAddress;
+    discover();
+    buildListing();
+    outOfDate = false;
+}
+
+void Disassembler::clear()
+{
+    isCode.fill(false);
+    isInstructionStart.fill(false);
+    listingList.clear();
+    hasCheckBox.clear();
+    addressToRow.clear();
+    firstAddress = 0;
+    endAddress = 0;
+    outOfDate = false;
+}
+
+bool Disassembler::isEmpty()
+{
+    return listingList.isEmpty();
+}
+
+void Disassembler::memoryWritten(const QSet<int> &addresses)
+{
+    if (outOfDate || listingList.isEmpty()) {
+        return;
+    }
+    QSetIterator<int> i(addresses);
+    while (i.hasNext()) {
+        if (isCode.testBit(i.next())) {
+            outOfDate = true;
+            return;
+        }
+    }
+}
+
+bool Disassembler::update()
+{
+    if (!outOfDate) {
+        return false;
+    }
+    disassemble(entryAddress, firstAddress, endAddress);
+    return true;
+}
+
+QStringList Disassembler::getListing()
+{
+    return listingList;
+}
+
+QList<bool> Disassembler::getHasCheckBox()
+{
+    return hasCheckBox;
+}
+
+QMap<int, int> Disassembler::getAddressToRow()
+{
+    return addressToRow;
+}
+
+void Disassembler::discover()
+{
+    isCode.fill(false);
+    isInstructionStart.fill(false);
+    QList<int> pending;
+    pending.append(entryAddress);
+    while (!pending.isEmpty()) {
+        int address = pending.takeLast();
+        // Follow the flow until it ends, joins code that is already decoded, or enters the OS,
+        // which has its own listing.
+        while (address < Pep::romStartAddress && !isCode.testBit(address)) {
+            int instructionSpecifier = Sim::Mem[address];
+            int length = instructionLength(instructionSpecifier);
+            if (!isValidInstruction(instructionSpecifier) || address + length > memorySize) {
+                break;
+            }
+            isInstructionStart.setBit(address);
+            for (int i = 0; i < length; i++) {
+                isCode.setBit(address + i);
+            }
+            EMnemonic mnemonic = Pep::decodeMnemonic[instructionSpecifier];
+            if ((FlowGraph::isBranch(mnemonic) || mnemonic == CALL) && Pep::decodeAddrMode[instructionSpecifier] == I) {
+                pending.append(Sim::Mem[address + 1] * 256 + Sim::Mem[address + 2]);
+            }
+            if (FlowGraph::endsFlow(mnemonic) || address + length >= memorySize) {
+                break;
+            }
+            address += length;
+        }
+    }
+}
+
+void Disassembler::buildListing()
+{
+    listingList.clear();
+    hasCheckBox.clear();
+    addressToRow.clear();
+    int address = 0;
+    while (address < memorySize) {
+        if (isInstructionStart.testBit(address)) {
+            addressToRow.insert(address, listingList.size());
+            listingList.append(instructionRow(address));
+            hasCheckBox.append(true);
+            address += instructionLength(Sim::Mem[address]);
+        }
+        else if (address >= firstAddress && address < endAddress) {
+            // Data runs up to the next instruction or the end of the program.
+            int length = 0;
+            while (length < dataBytesPerRow && address + length < endAddress
+                   && !isInstructionStart.testBit(address + length)) {
+                length++;
+            }
+            listingList.append(dataRow(address, length));
+            hasCheckBox.append(false);
+            address += length;
+        }
+        else {
+            address++;
+        }
+    }
+}
+
+QString Disassembler::instructionRow(int address)
+{
+    int instructionSpecifier = Sim::Mem[address];
+    EMnemonic mnemonic = Pep::decodeMnemonic[instructionSpecifier];
+    EAddrMode addressingMode = Pep::decodeAddrMode[instructionSpecifier];
+    QString memStr = QString("%1").arg(address, 4, 16, QLatin1Char('0')).toUpper();
+    QString codeStr = QString("%1").arg(instructionSpecifier, 2, 16, QLatin1Char('0')).toUpper();
+    QString mnemonStr = Pep::enumToMnemonMap.value(mnemonic);
+    if (Pep::isUnaryMap.value(mnemonic)) {
+        return QString("%1%2%3%4")
+                .arg(memStr, -6, QLatin1Char(' '))
+                .arg(codeStr, -7, QLatin1Char(' '))
+                .arg("", -9, QLatin1Char(' '))
+                .arg(mnemonStr);
+    }
+    int operand = Sim::Mem[address + 1] * 256 + Sim::Mem[address + 2];
+    QString oprndNumStr = QString("%1").arg(operand, 4, 16, QLatin1Char('0')).toUpper();
+    QString oprndStr = "0x" + oprndNumStr;
+    if (Pep::addrModeRequiredMap.value(mnemonic) || addressingMode == X) {
+        oprndStr.append("," + Pep::intToAddrMode(addressingMode));
+    }
+    return QString("%1%2%3%4%5%6")
+            .arg(memStr, -6, QLatin1Char(' '))
+            .arg(codeStr, -2)
+            .arg(oprndNumStr, -5, QLatin1Char(' '))
+            .arg("", -9, QLatin1Char(' '))
+            .arg(mnemonStr, -8, QLatin1Char(' '))
+            .arg(oprndStr);
+}
+
+QString Disassembler::dataRow(int address, int length)
+{
+    QString memStr = QString("%1").arg(address, 4, 16, QLatin1Char('0')).toUpper();
+    QString codeStr = "";
+    for (int i = 0; i < length; i++) {
+        codeStr.append(QString("%1").arg(Sim::Mem[address + i], 2, 16, QLatin1Char('0')).toUpper());
+    }
+    QString dotStr = length == 2 ? ".WORD" : ".BYTE";
+    QString oprndStr = "0x" + codeStr;
+    return QString("%1%2%3%4%5")
+            .arg(memStr, -6, QLatin1Char(' '))
+            .arg(codeStr, -7, QLatin1Char(' '))
+            .arg("", -9, QLatin1Char(' '))
+            .arg(dotStr, -8, QLatin1Char(' '))
+            .arg(oprndStr);
+}
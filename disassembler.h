@@ -0,0 +1,105 @@
+// File: disassembler.h
+/*
+    Pep8-1 is a virtual machine for writing machine language and assembly
+    language programs.
+    
+    Copyright (C) 2009  J. Stanley Warford, Pepperdine University
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef DISASSEMBLER_H
+#define DISASSEMBLER_H
+
+#include <QBitArray>
+#include <QList>
+#include <QMap>
+#include <QSet>
+#include <QStringList>
+
+// The disassembler lists a program from memory when there is no assembler listing for it, as
+// for Start Debugging Object and Start Debugging Loader. Code is found by recursive descent from
+// the entry point: an instruction leads to the next one unless it ends the flow, and a branch or
+// CALL with an immediate operand also leads to its target. Bytes that no path reaches are data,
+// so the data after the code is not listed as instructions. A branch through a table (,x) has
+// no known target, so the code it reaches is listed as data. The OS in ROM is not decoded.
+// The listing has the columns of the assembler listing. It is decoded again only when the
+// program writes to the bytes of a decoded instruction, as the loader does when it loads the
+// program over the initial memory.
+class Disassembler
+{
+public:
+    Disassembler();
+
+    static QString instructionString(int instructionSpecifier);
+    // Post: Returns the mnemonic of instructionSpecifier followed by its addressing mode, if it has one.
+
+    static int instructionLength(int instructionSpecifier);
+    // Post: Returns 1 if instructionSpecifier is a unary instruction, and 3 otherwise.
+
+    static bool isValidInstruction(int instructionSpecifier);
+    // Post: Returns true if the addressing mode of instructionSpecifier is legal for its mnemonic.
+
+    void disassemble(int entryAddress, int firstAddress, int endAddress);
+    // Pre: Sim::Mem holds the program from firstAddress up to but not including endAddress.
+    // Post: The code reachable from entryAddress is decoded and the bytes from firstAddress to
+    // endAddress, and any code reached beyond them, are listed.
+
+    void clear();
+    // Post: The disassembly is empty.
+
+    bool isEmpty();
+    // Post: Returns true if there is no disassembly.
+
+    void memoryWritten(const QSet<int> &addresses);
+    // Post: The disassembly is out of date if one of addresses is a byte of a decoded instruction.
+
+    bool update();
+    // Post: If the disassembly is out of date, it is decoded and listed again from memory and true
+    // is returned. Otherwise false is returned.
+
+    QStringList getListing();
+    // Post: Returns the listing, one row per instruction and one .WORD row per two bytes of data,
+    // or a .BYTE row for a byte before an instruction or the end of the program.
+
+    QList<bool> getHasCheckBox();
+    // Post: Returns, for each row, whether a break point can be set on it.
+
+    QMap<int, int> getAddressToRow();
+    // Post: Returns the map from the address of each instruction to its row.
+
+private:
+    int entryAddress;
+    int firstAddress;
+    int endAddress;
+    bool outOfDate;
+    QBitArray isCode; // One bit per byte of memory, set for the bytes of decoded instructions
+    QBitArray isInstructionStart;
+
+    QStringList listingList;
+    QList<bool> hasCheckBox;
+    QMap<int, int> addressToRow;
+
+    void discover();
+    // Post: isCode and isInstructionStart hold the code reachable from entryAddress.
+
+    void buildListing();
+    // Post: listingList, hasCheckBox and addressToRow list the decoded code and the data.
+
+    QString instructionRow(int address);
+    QString dataRow(int address, int length);
+};
+
+#endif // DISASSEMBLER_H
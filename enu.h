@@ -60,6 +60,14 @@ namespace Enu
         F_NONE, F_1C, F_1D, F_2D, F_1H, F_2H
     };
 
+    // Kind of symbol table entry
+    enum ESymbolKind
+    {
+        K_UNDEFINED, // Referenced but not (yet) defined
+        K_LABEL, // Defined by a symbol definition, value is a memory address
+        K_EQUATE // Defined by .EQUATE, value is a constant
+    };
+
     enum EExecState
     {
         EStart,
@@ -85,6 +93,13 @@ namespace Enu
         ETerminal,
     };
 
+    enum EAssembly
+    {
+        EProgram, // A program to load at address 0, without .BURN
+        EModule, // A relocatable module, whose undefined symbols are imports
+        EOperatingSystem // An OS with exactly one .BURN
+    };
+
 }
 
 #endif // ENU_H
@@ -0,0 +1,438 @@
+// File: flowgraph.cpp
+/*
+    Pep8-1 is a virtual machine for writing machine language and assembly
+    language programs.
+    
+    Copyright (C) 2009  J. Stanley Warford, Pepperdine University
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <QBitArray>
+#include <QHash>
+#include <QSet>
+#include <QVector>
+#include "flowgraph.h"
+#include "code.h"
+#include "argument.h"
+#include "pep.h"
+
+using namespace Enu;
+
+// Bytes a trap pushes on the system stack plus the two vectors it reads
+static const int trapContextCost = 14;
+
+// Loop depth beyond which the estimate weight stops growing
+static const int maxWeightedLoopDepth = 4;
+
+// An instruction of the program, in address order
+struct FlowInstruction
+{
+    int address;
+    int length;
+    EMnemonic mnemonic;
+    EAddrMode addressingMode;
+    int target; // Operand value of a branch or CALL
+    QString targetName;
+    QString symbolDef;
+};
+
+int FlowGraph::operandCost(Enu::EAddrMode addressingMode, int operandSize)
+{
+    switch (addressingMode) {
+    case I: return 0;
+    case D: case S: case X: case SX: return operandSize;
+    case N: case SF: case SXF: return 2 + operandSize;
+    default: return 0;
+    }
+}
+
+bool FlowGraph::isBranch(Enu::EMnemonic mnemonic)
+{
+    switch (mnemonic) {
+    case BR: case BRC: case BREQ: case BRGE: case BRGT: case BRLE: case BRLT: case BRNE: case BRV:
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool FlowGraph::endsFlow(Enu::EMnemonic mnemonic)
+{
+    switch (mnemonic) {
+    case BR: case STOP: case RETTR:
+    case RET0: case RET1: case RET2: case RET3: case RET4: case RET5: case RET6: case RET7:
+        return true;
+    default:
+        return false;
+    }
+}
+
+int FlowGraph::cost(Enu::EMnemonic mnemonic, Enu::EAddrMode addressingMode)
+{
+    if (Pep::isUnaryMap.value(mnemonic)) {
+        if (Pep::isTrapMap.value(mnemonic)) {
+            return 1 + trapContextCost;
+        }
+        switch (mnemonic) {
+        case RET0: case RET1: case RET2: case RET3: case RET4: case RET5: case RET6: case RET7:
+            return 1 + 2;
+        case RETTR:
+            return 1 + 10;
+        default:
+            return 1;
+        }
+    }
+    if (Pep::isTrapMap.value(mnemonic)) {
+        return 3 + trapContextCost;
+    }
+    switch (mnemonic) {
+    case CALL:
+        return 3 + (addressingMode == X ? 2 : 0) + 2;
+    case LDBYTEA: case LDBYTEX: case STBYTEA: case STBYTEX: case CHARI: case CHARO:
+        return 3 + operandCost(addressingMode, 1);
+    default:
+        if (isBranch(mnemonic)) {
+            return 3 + (addressingMode == X ? 2 : 0);
+        }
+        return 3 + operandCost(addressingMode, 2);
+    }
+}
+
+void FlowGraph::build(const QList<Code *> &codeList, QList<Block> &blocks, QList<Routine> &routines,
+                      QMap<int, int> &instructionCost)
+{
+    blocks.clear();
+    routines.clear();
+    instructionCost.clear();
+
+    QList<FlowInstruction> program;
+    for (int i = 0; i < codeList.size(); i++) {
+        FlowInstruction instr;
+        instr.address = codeList[i]->memAddress;
+        instr.symbolDef = codeList[i]->symbolDef;
+        instr.target = -1;
+        if (UnaryInstruction *unary = dynamic_cast<UnaryInstruction *>(codeList[i])) {
+            instr.length = 1;
+            instr.mnemonic = unary->mnemonic;
+            instr.addressingMode = NONE;
+        }
+        else if (NonUnaryInstruction *nonUnary = dynamic_cast<NonUnaryInstruction *>(codeList[i])) {
+            instr.length = 3;
+            instr.mnemonic = nonUnary->mnemonic;
+            instr.addressingMode = nonUnary->addressingMode;
+            if (isBranch(instr.mnemonic) || instr.mnemonic == CALL) {
+                instr.target = nonUnary->argument->getArgumentValue();
+                if (nonUnary->argument->isSymbolRef()) {
+                    instr.targetName = nonUnary->argument->getArgumentString();
+                }
+            }
+        }
+        else {
+            continue;
+        }
+        instructionCost.insert(instr.address, cost(instr.mnemonic, instr.addressingMode));
+        program.append(instr);
+    }
+    if (program.isEmpty()) {
+        return;
+    }
+
+    // An instruction leads a block if it is the target of a branch or CALL, or if it does not
+    // directly follow an instruction that falls through to it.
+    QSet<int> leaders;
+    leaders.insert(program[0].address);
+    for (int i = 0; i < program.size(); i++) {
+        const FlowInstruction &instr = program[i];
+        if (instr.target >= 0 && instr.addressingMode == I && instructionCost.contains(instr.target)) {
+            leaders.insert(instr.target);
+        }
+        if (i + 1 < program.size()
+            && (isBranch(instr.mnemonic) || endsFlow(instr.mnemonic)
+                || program[i + 1].address != instr.address + instr.length)) {
+            leaders.insert(program[i + 1].address);
+        }
+    }
+
+    QHash<int, int> blockOfAddress;
+    QList<int> lastInstruction; // Index in program of the last instruction of each block
+    for (int i = 0; i < program.size(); i++) {
+        if (leaders.contains(program[i].address)) {
+            Block block;
+            block.firstAddress = program[i].address;
+            block.cost = 0;
+            block.loopDepth = 0;
+            block.routine = -1;
+            block.hasUnknownSuccessors = false;
+            blockOfAddress.insert(block.firstAddress, blocks.size());
+            blocks.append(block);
+            lastInstruction.append(i);
+        }
+        blocks.last().lastAddress = program[i].address;
+        blocks.last().cost += instructionCost.value(program[i].address);
+        lastInstruction.last() = i;
+    }
+
+    for (int b = 0; b < blocks.size(); b++) {
+        int i = lastInstruction[b];
+        const FlowInstruction &instr = program[i];
+        if (isBranch(instr.mnemonic)) {
+            if (instr.addressingMode == I) {
+                if (blockOfAddress.contains(instr.target)) {
+                    blocks[b].successors.append(blockOfAddress.value(instr.target));
+                }
+            }
+            else {
+                blocks[b].hasUnknownSuccessors = true;
+            }
+        }
+        if (!endsFlow(instr.mnemonic) && i + 1 < program.size()
+            && program[i + 1].address == instr.address + instr.length
+            && !blocks[b].successors.contains(b + 1)) {
+            blocks[b].successors.append(b + 1);
+        }
+    }
+
+    // The program entry is at address 0 when there is an instruction there.
+    Routine entry;
+    entry.entryAddress = blockOfAddress.contains(0) ? 0 : blocks[0].firstAddress;
+    entry.name = program[0].address == entry.entryAddress && !program[0].symbolDef.isEmpty()
+                 ? program[0].symbolDef : QString("(entry)");
+    routines.append(entry);
+    for (int i = 0; i < program.size(); i++) {
+        const FlowInstruction &instr = program[i];
+        if (instr.mnemonic != CALL || instr.addressingMode != I || !blockOfAddress.contains(instr.target)) {
+            continue;
+        }
+        bool known = false;
+        for (int r = 0; r < routines.size() && !known; r++) {
+            known = routines[r].entryAddress == instr.target;
+        }
+        if (!known) {
+            Routine routine;
+            routine.entryAddress = instr.target;
+            routine.name = instr.targetName.isEmpty()
+                           ? QString("%1").arg(instr.target, 4, 16, QLatin1Char('0')).toUpper()
+                           : instr.targetName;
+            routines.append(routine);
+        }
+    }
+
+    QList<int> entryBlocks;
+    for (int r = 0; r < routines.size(); r++) {
+        int entryBlock = blockOfAddress.value(routines[r].entryAddress);
+        entryBlocks.append(entryBlock);
+        QVector<bool> visited(blocks.size(), false);
+        QList<int> stack;
+        stack.append(entryBlock);
+        visited[entryBlock] = true;
+        while (!stack.isEmpty()) {
+            int b = stack.takeLast();
+            routines[r].blocks.append(b);
+            if (blocks[b].routine < 0) {
+                blocks[b].routine = r;
+            }
+            for (int s = 0; s < blocks[b].successors.size(); s++) {
+                int succ = blocks[b].successors[s];
+                if (!visited[succ]) {
+                    visited[succ] = true;
+                    stack.append(succ);
+                }
+            }
+        }
+        qSort(routines[r].blocks);
+    }
+
+    findLoops(blocks, entryBlocks);
+
+    for (int r = 0; r < routines.size(); r++) {
+        routines[r].cost = 0;
+        routines[r].estimate = 0;
+        for (int i = 0; i < routines[r].blocks.size(); i++) {
+            const Block &block = blocks[routines[r].blocks[i]];
+            int weight = 1;
+            for (int d = 0; d < qMin(block.loopDepth, maxWeightedLoopDepth); d++) {
+                weight *= 10;
+            }
+            routines[r].cost += block.cost;
+            routines[r].estimate += block.cost * weight;
+        }
+    }
+}
+
+void FlowGraph::findLoops(QList<Block> &blocks, const QList<int> &entryBlocks)
+{
+    // Dominators over the blocks plus a virtual root whose successors are the routine entries
+    int root = blocks.size();
+    int nodeCount = blocks.size() + 1;
+    QVector<QList<int> > predecessors(nodeCount);
+    for (int b = 0; b < blocks.size(); b++) {
+        for (int s = 0; s < blocks[b].successors.size(); s++) {
+            predecessors[blocks[b].successors[s]].append(b);
+        }
+    }
+    for (int i = 0; i < entryBlocks.size(); i++) {
+        predecessors[entryBlocks[i]].append(root);
+    }
+
+    QVector<bool> reachable(nodeCount, false);
+    QList<int> stack = entryBlocks;
+    reachable[root] = true;
+    for (int i = 0; i < entryBlocks.size(); i++) {
+        reachable[entryBlocks[i]] = true;
+    }
+    while (!stack.isEmpty()) {
+        int b = stack.takeLast();
+        for (int s = 0; s < blocks[b].successors.size(); s++) {
+            int succ = blocks[b].successors[s];
+            if (!reachable[succ]) {
+                reachable[succ] = true;
+                stack.append(succ);
+            }
+        }
+    }
+
+    QVector<QBitArray> dominators(nodeCount, QBitArray(nodeCount, true));
+    dominators[root] = QBitArray(nodeCount, false);
+    dominators[root].setBit(root);
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (int b = 0; b < blocks.size(); b++) {
+            if (!reachable[b]) {
+                continue;
+            }
+            QBitArray dom(nodeCount, true);
+            for (int p = 0; p < predecessors[b].size(); p++) {
+                if (reachable[predecessors[b][p]]) {
+                    dom &= dominators[predecessors[b][p]];
+                }
+            }
+            dom.setBit(b);
+            if (dom != dominators[b]) {
+                dominators[b] = dom;
+                changed = true;
+            }
+        }
+    }
+
+    // The natural loop of a back edge tail -> header is the header plus every block that
+    // reaches the tail without passing through the header. Loops that share a header are merged.
+    QMap<int, QBitArray> loopOfHeader;
+    for (int tail = 0; tail < blocks.size(); tail++) {
+        if (!reachable[tail]) {
+            continue;
+        }
+        for (int s = 0; s < blocks[tail].successors.size(); s++) {
+            int header = blocks[tail].successors[s];
+            if (!dominators[tail].testBit(header)) {
+                continue;
+            }
+            if (!loopOfHeader.contains(header)) {
+                loopOfHeader.insert(header, QBitArray(blocks.size(), false));
+                loopOfHeader[header].setBit(header);
+            }
+            QBitArray &loop = loopOfHeader[header];
+            QList<int> work;
+            if (!loop.testBit(tail)) {
+                loop.setBit(tail);
+                work.append(tail);
+            }
+            while (!work.isEmpty()) {
+                int b = work.takeLast();
+                for (int p = 0; p < predecessors[b].size(); p++) {
+                    int pred = predecessors[b][p];
+                    if (pred != root && reachable[pred] && !loop.testBit(pred)) {
+                        loop.setBit(pred);
+                        work.append(pred);
+                    }
+                }
+            }
+        }
+    }
+    QMapIterator<int, QBitArray> it(loopOfHeader);
+    while (it.hasNext()) {
+        it.next();
+        for (int b = 0; b < blocks.size(); b++) {
+            if (it.value().testBit(b)) {
+                blocks[b].loopDepth++;
+            }
+        }
+    }
+}
+
+void FlowGraph::annotate(const QList<Code *> &codeList, QMap<int, QString> &annotationOfAddress,
+                         QStringList &summaryList)
+{
+    QList<Block> blocks;
+    QList<Routine> routines;
+    QMap<int, int> instructionCost;
+    build(codeList, blocks, routines, instructionCost);
+    annotationOfAddress.clear();
+    summaryList.clear();
+    if (blocks.isEmpty()) {
+        return;
+    }
+
+    for (int b = 0; b < blocks.size(); b++) {
+        const Block &block = blocks[b];
+        QMap<int, int>::const_iterator it = instructionCost.lowerBound(block.firstAddress);
+        for (; it != instructionCost.constEnd() && it.key() <= block.lastAddress; ++it) {
+            QString blockStr = it.key() == block.firstAddress ? QString("B%1").arg(b) : QString();
+            QString depthStr = block.loopDepth > 0 ? QString::number(block.loopDepth) : QString();
+            annotationOfAddress.insert(it.key(), QString("%1%2%3  ")
+                                       .arg(blockStr, -5)
+                                       .arg(depthStr, 4)
+                                       .arg(it.value(), 5));
+        }
+    }
+
+    summaryList << "Cost estimate (bytes of memory accessed, weighted by 10 per loop level)";
+    summaryList << "--------------------------------------------------";
+    summaryList << "Routine     Entry  Blocks    Cost  Estimate";
+    summaryList << "--------------------------------------------------";
+    for (int r = 0; r < routines.size(); r++) {
+        summaryList << QString("%1%2%3%4%5")
+                       .arg(routines[r].name, -12)
+                       .arg(QString("%1").arg(routines[r].entryAddress, 4, 16, QLatin1Char('0')).toUpper(), -7)
+                       .arg(routines[r].blocks.size(), 6)
+                       .arg(routines[r].cost, 8)
+                       .arg(routines[r].estimate, 10);
+    }
+    summaryList << "--------------------------------------------------";
+    summaryList << "";
+    summaryList << "--------------------------------------------------";
+    summaryList << "Block  Addr       Loop  Cost  Routine     Next";
+    summaryList << "--------------------------------------------------";
+    for (int b = 0; b < blocks.size(); b++) {
+        const Block &block = blocks[b];
+        QStringList next;
+        for (int s = 0; s < block.successors.size(); s++) {
+            next << QString("B%1").arg(block.successors[s]);
+        }
+        if (block.hasUnknownSuccessors) {
+            next << "?";
+        }
+        summaryList << QString("%1%2-%3%4%5  %6%7")
+                       .arg(QString("B%1").arg(b), -7)
+                       .arg(QString("%1").arg(block.firstAddress, 4, 16, QLatin1Char('0')).toUpper())
+                       .arg(QString("%1").arg(block.lastAddress, 4, 16, QLatin1Char('0')).toUpper())
+                       .arg(block.loopDepth, 6)
+                       .arg(block.cost, 6)
+                       .arg(block.routine >= 0 ? routines[block.routine].name : QString(), -12)
+                       .arg(next.isEmpty() ? QString("-") : next.join(" "));
+    }
+    summaryList << "--------------------------------------------------";
+}
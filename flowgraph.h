@@ -0,0 +1,95 @@
+// File: flowgraph.h
+/*
+    Pep8-1 is a virtual machine for writing machine language and assembly
+    language programs.
+    
+    Copyright (C) 2009  J. Stanley Warford, Pepperdine University
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef FLOWGRAPH_H
+#define FLOWGRAPH_H
+
+#include <QList>
+#include <QMap>
+#include <QString>
+#include <QStringList>
+#include "enu.h"
+
+class Code;
+
+// The flow graph of an assembled program splits its instructions into basic blocks, links the
+// blocks by their branches, and groups them into routines, one for the program entry and one
+// for each CALL target. Branch and CALL targets are the values of their operands, so symbolic
+// targets are resolved through the symbol table. A branch through a table (,x) has no known
+// successors.
+// The static cost of an instruction is the number of bytes of memory it accesses, including its
+// own fetch. A trap counts the context switch but not the trap handler. The estimated cost of a
+// block weights its static cost by 10 for each loop that contains it.
+class FlowGraph
+{
+public:
+    struct Block
+    {
+        int firstAddress;
+        int lastAddress;
+        int cost; // Sum of the static costs of its instructions
+        int loopDepth; // Number of loops that contain the block
+        int routine; // Index of the first routine that reaches the block, or -1
+        bool hasUnknownSuccessors; // Ends in a branch through a table
+        QList<int> successors;
+    };
+
+    struct Routine
+    {
+        QString name;
+        int entryAddress;
+        QList<int> blocks;
+        int cost; // Sum of the costs of its blocks
+        int estimate; // Sum of the costs of its blocks weighted by loop depth
+    };
+
+    static void build(const QList<Code *> &codeList, QList<Block> &blocks, QList<Routine> &routines,
+                      QMap<int, int> &instructionCost);
+    // Pre: codeList is populated with code from a complete correct Pep/8 source program.
+    // Post: blocks are the basic blocks of the program in address order, routines are its
+    // routines with the program entry first, and instructionCost maps the address of each
+    // instruction to its static cost.
+
+    static int cost(Enu::EMnemonic mnemonic, Enu::EAddrMode addressingMode);
+    // Post: The static cost of the instruction is returned.
+
+    static void annotate(const QList<Code *> &codeList, QMap<int, QString> &annotationOfAddress,
+                         QStringList &summaryList);
+    // Pre: codeList is populated with code from a complete correct Pep/8 source program.
+    // Post: annotationOfAddress maps the address of each instruction to a listing column with
+    // its block, loop depth and static cost, and summaryList is a table of the routines and
+    // blocks of the program.
+
+    static const int annotationWidth = 16;
+
+    static bool isBranch(Enu::EMnemonic mnemonic);
+    // Post: Returns true if mnemonic is BR or a conditional branch.
+
+    static bool endsFlow(Enu::EMnemonic mnemonic);
+    // Post: Returns true if control never goes on to the next instruction after mnemonic.
+
+private:
+    static int operandCost(Enu::EAddrMode addressingMode, int operandSize);
+    static void findLoops(QList<Block> &blocks, const QList<int> &entryBlocks);
+};
+
+#endif // FLOWGRAPH_H
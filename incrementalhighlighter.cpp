@@ -0,0 +1,87 @@
+// File: incrementalhighlighter.cpp
+/*
+    Pep8-1 is a virtual machine for writing machine language and assembly
+    language programs.
+    
+    Copyright (C) 2009  J. Stanley Warford, Pepperdine University
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <QTextDocument>
+#include <QTimer>
+#include "incrementalhighlighter.h"
+
+IncrementalHighlighter::IncrementalHighlighter(QTextDocument *parent)
+    : QSyntaxHighlighter(parent)
+{
+    blocksThisTurn = 0;
+    firstPendingBlock = -1;
+    lastPendingBlock = -1;
+    idleScheduled = false;
+    highlightingPending = false;
+}
+
+void IncrementalHighlighter::highlightBlock(const QString &text)
+{
+    if (!highlightingPending && blocksThisTurn >= blocksPerTurn) {
+        // The block keeps its state, so QSyntaxHighlighter does not go on to the next block
+        // on its account.
+        int blockNumber = currentBlock().blockNumber();
+        if (firstPendingBlock < 0 || blockNumber < firstPendingBlock) {
+            firstPendingBlock = blockNumber;
+        }
+        lastPendingBlock = qMax(lastPendingBlock, blockNumber);
+        scheduleIdle();
+        return;
+    }
+    if (!highlightingPending) {
+        blocksThisTurn++;
+        scheduleIdle();
+    }
+    highlightLine(text);
+}
+
+void IncrementalHighlighter::scheduleIdle()
+{
+    if (!idleScheduled) {
+        idleScheduled = true;
+        QTimer::singleShot(0, this, SLOT(idle()));
+    }
+}
+
+void IncrementalHighlighter::idle()
+{
+    idleScheduled = false;
+    blocksThisTurn = 0;
+    if (firstPendingBlock < 0 || document() == 0) {
+        return;
+    }
+    QTextBlock block = document()->findBlockByNumber(firstPendingBlock);
+    highlightingPending = true;
+    for (int i = 0; i < blocksPerTurn && block.isValid() && block.blockNumber() <= lastPendingBlock; i++) {
+        rehighlightBlock(block);
+        block = block.next();
+    }
+    highlightingPending = false;
+    if (block.isValid() && block.blockNumber() <= lastPendingBlock) {
+        firstPendingBlock = block.blockNumber();
+        scheduleIdle();
+    }
+    else {
+        firstPendingBlock = -1;
+        lastPendingBlock = -1;
+    }
+}
@@ -0,0 +1,63 @@
+// File: incrementalhighlighter.h
+/*
+    Pep8-1 is a virtual machine for writing machine language and assembly
+    language programs.
+    
+    Copyright (C) 2009  J. Stanley Warford, Pepperdine University
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef INCREMENTALHIGHLIGHTER_H
+#define INCREMENTALHIGHLIGHTER_H
+
+#include <QSyntaxHighlighter>
+
+QT_BEGIN_NAMESPACE
+class QTextDocument;
+QT_END_NAMESPACE
+
+// A syntax highlighter that highlights at most blocksPerTurn blocks per turn of the event loop.
+// Loading or pasting a large text highlights its first blocks, the ones in view, at once, and
+// the remaining blocks are highlighted in idle time, blocksPerTurn at a time.
+class IncrementalHighlighter : public QSyntaxHighlighter
+{
+    Q_OBJECT
+public:
+    IncrementalHighlighter(QTextDocument *parent = 0);
+
+    static const int blocksPerTurn = 200;
+
+protected:
+    void highlightBlock(const QString &text);
+
+    virtual void highlightLine(const QString &text) = 0;
+    // Post: text, the text of the current block, is highlighted and the block state is set.
+
+private:
+    int blocksThisTurn;
+    int firstPendingBlock; // -1 if no block is pending
+    int lastPendingBlock;
+    bool idleScheduled;
+    bool highlightingPending;
+
+    void scheduleIdle();
+
+private slots:
+    void idle();
+    // Post: The block count of the turn is reset and the next pending blocks are highlighted.
+};
+
+#endif // INCREMENTALHIGHLIGHTER_H
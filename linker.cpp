@@ -0,0 +1,121 @@
+// File: linker.cpp
+/*
+    Pep8-1 is a virtual machine for writing machine language and assembly
+    language programs.
+    
+    Copyright (C) 2009  J. Stanley Warford, Pepperdine University
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <QFileInfo>
+#include <QHash>
+#include <QSet>
+#include <QVector>
+#include "linker.h"
+#include "objectfile.h"
+#include "pep.h"
+
+bool Linker::link(const QStringList &moduleFileNames, QList<int> &objectCode, QString &errorString)
+{
+    QList<QList<int> > images;
+    QList<QVector<Pep::Symbol> > moduleSymbols;
+    QList<QList<int> > relocationOffsets;
+    QList<QStringList> relocationSymbols;
+    QList<int> baseAddresses;
+    int baseAddress = 0;
+
+    // Place the modules and collect the symbols they define.
+    QHash<QString, int> globalValues;
+    QHash<QString, int> definingModules;
+    QSet<QString> multiplyDefined;
+    for (int m = 0; m < moduleFileNames.size(); m++) {
+        QList<int> image;
+        QVector<Pep::Symbol> symbols;
+        QList<int> offsets;
+        QStringList names;
+        if (!ObjectFile::readModule(moduleFileNames.at(m), image, symbols, offsets, names, errorString)) {
+            errorString = QFileInfo(moduleFileNames.at(m)).fileName() + ": " + errorString;
+            return false;
+        }
+        for (int i = 0; i < symbols.size(); i++) {
+            const Pep::Symbol &symbol = symbols.at(i);
+            if (symbol.kind == Enu::K_UNDEFINED) {
+                continue;
+            }
+            if (definingModules.contains(symbol.name)) {
+                multiplyDefined.insert(symbol.name);
+            }
+            definingModules.insert(symbol.name, m);
+            globalValues.insert(symbol.name, symbol.kind == Enu::K_LABEL ? baseAddress + symbol.value : symbol.value);
+        }
+        images.append(image);
+        moduleSymbols.append(symbols);
+        relocationOffsets.append(offsets);
+        relocationSymbols.append(names);
+        baseAddresses.append(baseAddress);
+        baseAddress += image.size();
+        if (baseAddress > 65536) {
+            errorString = "The linked program is too large to fit into memory.";
+            return false;
+        }
+    }
+
+    // Concatenate the images and patch every word that holds a label or an imported symbol.
+    objectCode.clear();
+    objectCode.reserve(baseAddress);
+    for (int m = 0; m < images.size(); m++) {
+        objectCode.append(images.at(m));
+    }
+    for (int m = 0; m < images.size(); m++) {
+        QHash<QString, int> localIds;
+        const QVector<Pep::Symbol> &symbols = moduleSymbols.at(m);
+        for (int i = 0; i < symbols.size(); i++) {
+            localIds.insert(symbols.at(i).name, i);
+        }
+        for (int r = 0; r < relocationOffsets.at(m).size(); r++) {
+            const QString &name = relocationSymbols.at(m).at(r);
+            int id = localIds.value(name, -1);
+            int value;
+            if (id >= 0 && symbols.at(id).kind == Enu::K_EQUATE) {
+                continue; // Equates are absolute.
+            }
+            else if (id >= 0 && symbols.at(id).kind == Enu::K_LABEL) {
+                value = baseAddresses.at(m) + symbols.at(id).value;
+            }
+            else if (multiplyDefined.contains(name)) {
+                errorString = QString("Symbol %1 used in %2 is defined in more than one module.")
+                              .arg(name).arg(QFileInfo(moduleFileNames.at(m)).fileName());
+                return false;
+            }
+            else if (globalValues.contains(name)) {
+                value = globalValues.value(name);
+            }
+            else {
+                errorString = QString("Symbol %1 used in %2 is not defined in any module.")
+                              .arg(name).arg(QFileInfo(moduleFileNames.at(m)).fileName());
+                return false;
+            }
+            int address = baseAddresses.at(m) + relocationOffsets.at(m).at(r);
+            if (address + 1 >= objectCode.size()) {
+                errorString = QFileInfo(moduleFileNames.at(m)).fileName() + ": The module file is corrupt.";
+                return false;
+            }
+            objectCode[address] = (value / 256) & 0xff;
+            objectCode[address + 1] = value % 256;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,43 @@
+// File: linker.h
+/*
+    Pep8-1 is a virtual machine for writing machine language and assembly
+    language programs.
+    
+    Copyright (C) 2009  J. Stanley Warford, Pepperdine University
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef LINKER_H
+#define LINKER_H
+
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+// The linker combines relocatable modules (.pepmod) into one program that loads at address 0.
+// Modules are placed one after the other in the order given. Every label a module defines is
+// relocated by the address of the module, and every symbol a module uses but does not define
+// is resolved to the label or equate of that name in the other modules.
+class Linker
+{
+public:
+    static bool link(const QStringList &moduleFileNames, QList<int> &objectCode, QString &errorString);
+    // Post: If every module can be read, every imported symbol is defined by exactly one other
+    // module, and the program fits in memory, the linked object code is returned and true is
+    // returned. Otherwise false is returned and errorString is set.
+};
+
+#endif // LINKER_H
@@ -0,0 +1,139 @@
+// File: listingtracemodel.cpp
+/*
+    Pep8-1 is a virtual machine for writing machine language and assembly
+    language programs.
+    
+    Copyright (C) 2009  J. Stanley Warford, Pepperdine University
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <QColor>
+#include "listingtracemodel.h"
+
+ListingTraceModel::ListingTraceModel(QObject *parent) :
+    QAbstractTableModel(parent)
+{
+    rowChecked = NULL;
+    highlightedRow = -1;
+    longestLineRow = -1;
+}
+
+int ListingTraceModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : lines.size();
+}
+
+int ListingTraceModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : 2;
+}
+
+QVariant ListingTraceModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid()) {
+        return QVariant();
+    }
+    int row = index.row();
+    if (index.column() == CheckBoxColumn) {
+        if (role == Qt::CheckStateRole && hasCheckBoxBits.testBit(row)) {
+            return checkedBits.testBit(row) ? Qt::Checked : Qt::Unchecked;
+        }
+        return QVariant();
+    }
+    if (role == Qt::DisplayRole) {
+        return lines.at(row);
+    }
+    if (row == highlightedRow) {
+        if (role == Qt::BackgroundRole) {
+            return QColor(56, 117, 215);
+        }
+        if (role == Qt::ForegroundRole) {
+            return QColor(Qt::white);
+        }
+    }
+    return QVariant();
+}
+
+bool ListingTraceModel::setData(const QModelIndex &index, const QVariant &value, int role)
+{
+    if (!index.isValid() || index.column() != CheckBoxColumn || role != Qt::CheckStateRole
+        || !hasCheckBoxBits.testBit(index.row())) {
+        return false;
+    }
+    Qt::CheckState state = static_cast<Qt::CheckState>(value.toInt());
+    checkedBits.setBit(index.row(), state == Qt::Checked);
+    if (rowChecked != NULL) {
+        rowChecked->insert(index.row(), state);
+    }
+    emit dataChanged(index, index);
+    return true;
+}
+
+Qt::ItemFlags ListingTraceModel::flags(const QModelIndex &index) const
+{
+    if (!index.isValid()) {
+        return Qt::NoItemFlags;
+    }
+    if (index.column() == CheckBoxColumn) {
+        return hasCheckBoxBits.testBit(index.row()) ? Qt::ItemIsEnabled | Qt::ItemIsUserCheckable : Qt::NoItemFlags;
+    }
+    return Qt::ItemIsEnabled;
+}
+
+void ListingTraceModel::setListing(const QStringList &listingTraceList, const QList<bool> &hasCheckBox,
+                                   QMap<int, Qt::CheckState> *listingRowChecked)
+{
+    lines = listingTraceList;
+    hasCheckBoxBits = QBitArray(lines.size());
+    for (int i = 0; i < lines.size() && i < hasCheckBox.size(); i++) {
+        hasCheckBoxBits.setBit(i, hasCheckBox.at(i));
+    }
+    checkedBits = QBitArray(lines.size());
+    rowChecked = listingRowChecked;
+    highlightedRow = -1;
+    longestLineRow = -1;
+    for (int i = 0; i < lines.size(); i++) {
+        if (longestLineRow < 0 || lines.at(i).length() > lines.at(longestLineRow).length()) {
+            longestLineRow = i;
+        }
+    }
+    reset();
+}
+
+void ListingTraceModel::clear()
+{
+    setListing(QStringList(), QList<bool>(), NULL);
+}
+
+QString ListingTraceModel::longestLine() const
+{
+    return longestLineRow < 0 ? QString() : lines.at(longestLineRow);
+}
+
+void ListingTraceModel::setHighlightedRow(int row)
+{
+    if (row == highlightedRow) {
+        return;
+    }
+    int oldRow = highlightedRow;
+    highlightedRow = row;
+    if (oldRow >= 0 && oldRow < lines.size()) {
+        emit dataChanged(index(oldRow, LineColumn), index(oldRow, LineColumn));
+    }
+    if (row >= 0 && row < lines.size()) {
+        emit dataChanged(index(row, LineColumn), index(row, LineColumn));
+    }
+}
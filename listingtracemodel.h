@@ -0,0 +1,72 @@
+// File: listingtracemodel.h
+/*
+    Pep8-1 is a virtual machine for writing machine language and assembly
+    language programs.
+    
+    Copyright (C) 2009  J. Stanley Warford, Pepperdine University
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef LISTINGTRACEMODEL_H
+#define LISTINGTRACEMODEL_H
+
+#include <QAbstractTableModel>
+#include <QBitArray>
+#include <QMap>
+#include <QStringList>
+
+// Table model of a listing trace. Column 0 holds the breakpoint check box of the rows that can
+// have one, and column 1 the listing line. The check boxes are a bit array mirrored into the
+// listingRowChecked map the simulator reads, and the row of the program counter is highlighted
+// as model state, so stepping changes two rows at most.
+class ListingTraceModel : public QAbstractTableModel
+{
+    Q_OBJECT
+public:
+    enum { CheckBoxColumn = 0, LineColumn = 1 };
+
+    explicit ListingTraceModel(QObject *parent = 0);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const;
+    bool setData(const QModelIndex &index, const QVariant &value, int role = Qt::EditRole);
+    Qt::ItemFlags flags(const QModelIndex &index) const;
+
+    void setListing(const QStringList &listingTraceList, const QList<bool> &hasCheckBox,
+                    QMap<int, Qt::CheckState> *listingRowChecked);
+    // Post: The model shows listingTraceList with no breakpoint set and no row highlighted.
+    // Breakpoints set later are recorded in listingRowChecked.
+
+    void clear();
+    // Post: The model has no rows.
+
+    QString longestLine() const;
+    // Post: The longest listing line is returned, to size the line column.
+
+    void setHighlightedRow(int row);
+    // Post: row is highlighted, or no row if row is -1.
+
+private:
+    QStringList lines;
+    QBitArray hasCheckBoxBits;
+    QBitArray checkedBits;
+    QMap<int, Qt::CheckState> *rowChecked;
+    int highlightedRow;
+    int longestLineRow;
+};
+
+#endif // LISTINGTRACEMODEL_H
@@ -20,6 +20,8 @@
 */
 #include <QFontDialog>
 #include <QScrollBar>
+#include <QHeaderView>
+#include <QStyle>
 #include "listingtracepane.h"
 #include "ui_listingtracepane.h"
 #include "sim.h"
@@ -33,17 +35,23 @@ ListingTracePane::ListingTracePane(QWidget *parent) :
 {
     ui->setupUi(this);
 
-    ui->listingPepOsTraceTableWidget->hide();
+    programModel = new ListingTraceModel(this);
+    osModel = new ListingTraceModel(this);
+    ui->listingTraceTableView->setModel(programModel);
+    ui->listingPepOsTraceTableView->setModel(osModel);
+    ui->listingTraceTableView->verticalHeader()->setResizeMode(QHeaderView::Fixed);
+    ui->listingPepOsTraceTableView->verticalHeader()->setResizeMode(QHeaderView::Fixed);
 
-    connect(ui->listingTraceTableWidget, SIGNAL(itemClicked(QTableWidgetItem*)), this, SLOT(updateIsCheckedTable(QTableWidgetItem*)));
-    connect(ui->listingPepOsTraceTableWidget, SIGNAL(itemClicked(QTableWidgetItem*)), this, SLOT(updateIsCheckedTable(QTableWidgetItem*)));
+    ui->listingPepOsTraceTableView->hide();
 
 //    programDocWidth = 0;
 //    osDocWidth = 0;
 
     ui->label->setFont(QFont(Pep::labelFont, Pep::labelFontSize));
-    ui->listingPepOsTraceTableWidget->setFont(QFont(Pep::codeFont, Pep::codeFontSize));
-    ui->listingTraceTableWidget->setFont(QFont(Pep::codeFont, Pep::codeFontSize));
+    ui->listingPepOsTraceTableView->setFont(QFont(Pep::codeFont, Pep::codeFontSize));
+    ui->listingTraceTableView->setFont(QFont(Pep::codeFont, Pep::codeFontSize));
+    resizeCells(ui->listingTraceTableView, programModel);
+    resizeCells(ui->listingPepOsTraceTableView, osModel);
 }
 
 ListingTracePane::~ListingTracePane()
@@ -53,35 +61,19 @@ ListingTracePane::~ListingTracePane()
 
 void ListingTracePane::setListingTrace(QStringList listingTraceList, QList<bool> hasCheckBox)
 {
-    // tableWidget depends on whether we are assembling the OS or a program
-    QTableWidget *tableWidget;
+    // The table depends on whether we are assembling the OS or a program
+    QTableView *tableView;
+    ListingTraceModel *model;
     if (Pep::memAddrssToAssemblerListing == &Pep::memAddrssToAssemblerListingProg) {
-        tableWidget = ui->listingTraceTableWidget;
+        tableView = ui->listingTraceTableView;
+        model = programModel;
     }
     else {
-        tableWidget = ui->listingPepOsTraceTableWidget;
-    }
-    QTableWidgetItem *item;
-    int numRows = listingTraceList.size();
-    tableWidget->setRowCount(numRows);
-    for (int i = 0; i < numRows; i++) {
-        item = new QTableWidgetItem(listingTraceList[i]);
-        tableWidget->setItem(i, 1, item);
-    }
-    for (int i = 0; i < numRows; i++) {
-        item = new QTableWidgetItem();
-        if (hasCheckBox[i]) {
-            item->setFlags(Qt::ItemIsEnabled | Qt::ItemIsUserCheckable);
-            item->setCheckState(Qt::Unchecked);
-        }
-        else {
-            item->setFlags(Qt::NoItemFlags);
-        }
-        tableWidget->setItem(i, 0, item);
-    }
-    tableWidget->resizeColumnsToContents();
-    ui->listingTraceTableWidget->width();
-    tableWidget->resizeRowsToContents();
+        tableView = ui->listingPepOsTraceTableView;
+        model = osModel;
+    }
+    model->setListing(listingTraceList, hasCheckBox, Pep::listingRowChecked);
+    resizeCells(tableView, model);
 //    if (Pep::memAddrssToAssemblerListing == &Pep::memAddrssToAssemblerListingProg) {
 //        programDocWidth = tableWidget->columnWidth(1);
 //    }
@@ -89,90 +81,97 @@ void ListingTracePane::setListingTrace(QStringList listingTraceList, QList<bool>
 //        osDocWidth = tableWidget->columnWidth(1);
 //    }
 //    resizeDocWidth();
-    tableWidget->horizontalScrollBar()->setValue(tableWidget->horizontalScrollBar()->minimum());
+    tableView->horizontalScrollBar()->setValue(tableView->horizontalScrollBar()->minimum());
 }
 
 void ListingTracePane::clearListingTrace()
 {
-    for (int i = 0; i < ui->listingTraceTableWidget->rowCount(); i++) {
-        delete ui->listingTraceTableWidget->itemAt(i, 0);
-        delete ui->listingTraceTableWidget->itemAt(i, 1);
-    }
-    ui->listingTraceTableWidget->setRowCount(0);
+    programModel->clear();
 }
 
 void ListingTracePane::updateListingTrace()
 {
-    // tableWidget depends on whether we are in the OS or a program
-    QTableWidget *tableWidget;
+    // The table depends on whether we are in the OS or a program
+    QTableView *tableView;
+    ListingTraceModel *model;
     if (Sim::trapped) {
-        tableWidget = ui->listingPepOsTraceTableWidget;
-        ui->listingPepOsTraceTableWidget->show();
-        ui->listingTraceTableWidget->hide();
+        tableView = ui->listingPepOsTraceTableView;
+        model = osModel;
+        ui->listingPepOsTraceTableView->show();
+        ui->listingTraceTableView->hide();
     }
     else {
-        tableWidget = ui->listingTraceTableWidget;
-        ui->listingPepOsTraceTableWidget->hide();
-        ui->listingTraceTableWidget->show();
+        tableView = ui->listingTraceTableView;
+        model = programModel;
+        ui->listingPepOsTraceTableView->hide();
+        ui->listingTraceTableView->show();
     }
 
-    for (int i = highlightedItemList.size() - 1; i >= 0; i--) {
-        highlightedItemList.at(i)->setBackgroundColor(Qt::white);
-        highlightedItemList.at(i)->setTextColor(Qt::black);
-        highlightedItemList.removeLast();
-    }
+    programModel->setHighlightedRow(-1);
+    osModel->setHighlightedRow(-1);
     if (Pep::memAddrssToAssemblerListing->contains(Sim::programCounter)) {
-        QTableWidgetItem *highlightedItem = tableWidget->item(Pep::memAddrssToAssemblerListing->value(Sim::programCounter), 1);
-        highlightedItem->setBackgroundColor(QColor(56, 117, 215));
-        highlightedItem->setTextColor(Qt::white);
-        highlightedItemList.append(highlightedItem);
-
-        tableWidget->scrollToItem(highlightedItem);
+        int row = Pep::memAddrssToAssemblerListing->value(Sim::programCounter);
+        model->setHighlightedRow(row);
+        tableView->scrollTo(model->index(row, ListingTraceModel::LineColumn));
     }
-    tableWidget->horizontalScrollBar()->setValue(tableWidget->horizontalScrollBar()->minimum());
+    tableView->horizontalScrollBar()->setValue(tableView->horizontalScrollBar()->minimum());
 }
 
 void ListingTracePane::setDebuggingState(bool b)
 {
-    QTableWidget *tableWidget;
+    QTableView *tableView;
+    ListingTraceModel *model;
     if (Sim::trapped) {
-        tableWidget = ui->listingPepOsTraceTableWidget;
-        ui->listingPepOsTraceTableWidget->show();
-        ui->listingTraceTableWidget->hide();
+        tableView = ui->listingPepOsTraceTableView;
+        model = osModel;
+        ui->listingPepOsTraceTableView->show();
+        ui->listingTraceTableView->hide();
     }
     else {
-        tableWidget = ui->listingTraceTableWidget;
-        ui->listingPepOsTraceTableWidget->hide();
-        ui->listingTraceTableWidget->show();
+        tableView = ui->listingTraceTableView;
+        model = programModel;
+        ui->listingPepOsTraceTableView->hide();
+        ui->listingTraceTableView->show();
     }
 
-    for (int i = 0; i < tableWidget->rowCount(); i++) {
-        tableWidget->item(i, 1)->setBackgroundColor(Qt::white);
-        tableWidget->item(i, 1)->setTextColor(Qt::black);
-    }
-    highlightedItemList.clear();
-    
+    programModel->setHighlightedRow(-1);
+    osModel->setHighlightedRow(-1);
     if (b && Pep::memAddrssToAssemblerListing->contains(Sim::programCounter)) {
-        QTableWidgetItem *highlightedItem = tableWidget->item(Pep::memAddrssToAssemblerListing->value(Sim::programCounter), 1);
-        highlightedItem->setBackgroundColor(QColor(56, 117, 215));
-        highlightedItem->setTextColor(Qt::white);
-        highlightedItemList.append(highlightedItem);
-
-        tableWidget->scrollToItem(highlightedItem);
+        int row = Pep::memAddrssToAssemblerListing->value(Sim::programCounter);
+        model->setHighlightedRow(row);
+        tableView->scrollTo(model->index(row, ListingTraceModel::LineColumn));
     }
-    tableWidget->horizontalScrollBar()->setValue(tableWidget->horizontalScrollBar()->minimum());
+    tableView->horizontalScrollBar()->setValue(tableView->horizontalScrollBar()->minimum());
 //    resizeDocWidth();
 }
 
 void ListingTracePane::showAssemblerListing()
 {
-    ui->listingPepOsTraceTableWidget->hide();
-    ui->listingTraceTableWidget->show();
+    ui->listingPepOsTraceTableView->hide();
+    ui->listingTraceTableView->show();
+}
+
+int ListingTracePane::cursorAddress()
+{
+    QTableView *tableView;
+    QMap<int, int> *memAddrssToAssemblerListing;
+    if (!ui->listingTraceTableView->isHidden()) {
+        tableView = ui->listingTraceTableView;
+        memAddrssToAssemblerListing = &Pep::memAddrssToAssemblerListingProg;
+    }
+    else {
+        tableView = ui->listingPepOsTraceTableView;
+        memAddrssToAssemblerListing = &Pep::memAddrssToAssemblerListingOS;
+    }
+    if (!tableView->currentIndex().isValid()) {
+        return -1;
+    }
+    return memAddrssToAssemblerListing->key(tableView->currentIndex().row(), -1);
 }
 
 void ListingTracePane::highlightOnFocus()
 {
-    if (ui->listingTraceTableWidget->hasFocus() || ui->listingPepOsTraceTableWidget->hasFocus()) {
+    if (ui->listingTraceTableView->hasFocus() || ui->listingPepOsTraceTableView->hasFocus()) {
         ui->label->setAutoFillBackground(true);
     }
     else {
@@ -182,24 +181,34 @@ void ListingTracePane::highlightOnFocus()
 
 bool ListingTracePane::hasFocus()
 {
-    return ui->listingTraceTableWidget->hasFocus() || ui->listingPepOsTraceTableWidget->hasFocus();
+    return ui->listingTraceTableView->hasFocus() || ui->listingPepOsTraceTableView->hasFocus();
 }
 
 void ListingTracePane::setFont()
 {
     bool ok = false;
-    QFont font = QFontDialog::getFont(&ok, QFont(ui->listingTraceTableWidget->font()), this, "Set Listing Trace Font");
+    QFont font = QFontDialog::getFont(&ok, QFont(ui->listingTraceTableView->font()), this, "Set Listing Trace Font");
     if (ok) {
-        ui->listingTraceTableWidget->setFont(font);
-        ui->listingPepOsTraceTableWidget->setFont(font);
-        ui->listingTraceTableWidget->resizeColumnsToContents();
-        ui->listingPepOsTraceTableWidget->resizeColumnsToContents();
+        ui->listingTraceTableView->setFont(font);
+        ui->listingPepOsTraceTableView->setFont(font);
+        resizeCells(ui->listingTraceTableView, programModel);
+        resizeCells(ui->listingPepOsTraceTableView, osModel);
     }
 }
 
 void ListingTracePane::setFocus()
 {
-    ui->listingTraceTableWidget->isHidden() ? ui->listingPepOsTraceTableWidget->setFocus() : ui->listingTraceTableWidget->setFocus();
+    ui->listingTraceTableView->isHidden() ? ui->listingPepOsTraceTableView->setFocus() : ui->listingTraceTableView->setFocus();
+}
+
+void ListingTracePane::resizeCells(QTableView *tableView, ListingTraceModel *model)
+{
+    QFontMetrics metrics(tableView->font());
+    int padding = metrics.width(' ');
+    tableView->setColumnWidth(ListingTraceModel::CheckBoxColumn,
+                              tableView->style()->pixelMetric(QStyle::PM_IndicatorWidth) + 2 * padding);
+    tableView->setColumnWidth(ListingTraceModel::LineColumn, metrics.width(model->longestLine()) + 2 * padding);
+    tableView->verticalHeader()->setDefaultSectionSize(metrics.height() + 2);
 }
 
 //void ListingTracePane::resizeDocWidth()
@@ -221,19 +230,14 @@ void ListingTracePane::setFocus()
 
 void ListingTracePane::mouseReleaseEvent(QMouseEvent *)
 {
-    QTableWidget *tableWidget;
-    if (!ui->listingTraceTableWidget->isHidden()) {
-        tableWidget = ui->listingTraceTableWidget;
+    QTableView *tableView;
+    if (!ui->listingTraceTableView->isHidden()) {
+        tableView = ui->listingTraceTableView;
     }
     else {
-        tableWidget = ui->listingPepOsTraceTableWidget;
+        tableView = ui->listingPepOsTraceTableView;
     }
-    tableWidget->setFocus();
-}
-
-void ListingTracePane::updateIsCheckedTable(QTableWidgetItem *item)
-{
-    Pep::listingRowChecked->insert(item->row(), item->checkState());
+    tableView->setFocus();
 }
 
 void ListingTracePane::mouseDoubleClickEvent(QMouseEvent *)
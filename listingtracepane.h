@@ -23,8 +23,9 @@
 #define LISTINGTRACEPANE_H
 
 #include <QtGui/QWidget>
-#include <QTableWidgetItem>
+#include <QTableView>
 #include "enu.h"
+#include "listingtracemodel.h"
 
 namespace Ui {
     class ListingTracePane;
@@ -53,6 +54,10 @@ public:
     // Post: The tableWidget containing the assembler listing is shown
     // and the OS tableWidget is hidden
 
+    int cursorAddress();
+    // Post: Returns the address of the instruction on the current row of the visible listing,
+    // or -1 if that row holds no instruction
+
     void highlightOnFocus();
     // Post: Highlights the label based on the label window color saved in the UI file
 
@@ -73,17 +78,19 @@ private:
     Ui::ListingTracePane *ui;
 
     void mouseReleaseEvent(QMouseEvent *);
-    
-    QList<QTableWidgetItem *> highlightedItemList;
+
+    ListingTraceModel *programModel;
+    ListingTraceModel *osModel;
+
+    void resizeCells(QTableView *tableView, ListingTraceModel *model);
+    // Post: The columns of tableView fit the check box and the longest line of model, and its
+    // rows have the height of its font. Every row has the same height, so no row is measured.
 
 //    int programDocWidth;
 //    int osDocWidth;
     // These are commented, but preserved in case we want to bring back the resizing of the document width to the width of the window.
     void mouseDoubleClickEvent(QMouseEvent *);
 
-private slots:
-    void updateIsCheckedTable(QTableWidgetItem *item);
-
 signals:
     void labelDoubleClicked(Enu::EPane pane);
 
@@ -38,6 +38,10 @@
 #include "ui_mainwindow.h"
 #include "pep.h"
 #include "sim.h"
+#include "objectfile.h"
+#include "linker.h"
+#include "peephole.h"
+#include "flowgraph.h"
 
  #include <QDebug>
 
@@ -45,6 +49,9 @@ MainWindow::MainWindow(QWidget *parent)
         : QMainWindow(parent), ui(new Ui::MainWindowClass)
 {
     ui->setupUi(this);
+    programListingPending = false;
+    programAnnotationsPending = false;
+    loadedByteCount = 0;
 
     // Left pane setup
     sourceCodePane = new SourceCodePane(ui->codeSplitter);
@@ -81,6 +88,7 @@ MainWindow::MainWindow(QWidget *parent)
     aboutPepDialog = new AboutPep(this);
 
     connect(helpDialog, SIGNAL(clicked()), this, SLOT(helpCopyToSourceButtonClicked()));
+    connect(redefineMnemonicsDialog, SIGNAL(finished(int)), this, SLOT(redefineMnemonicsDialogFinished()));
 
     // Byte converter setup
     byteConverterDec = new ByteConverterDec();
@@ -114,9 +122,10 @@ MainWindow::MainWindow(QWidget *parent)
     // Install OS into memory
     Pep::memAddrssToAssemblerListing = &Pep::memAddrssToAssemblerListingOS;
     Pep::listingRowChecked = &Pep::listingRowCheckedOS;
-    if (sourceCodePane->installDefaultOs()) {
-        sourceCodePane->getAssemblerListingList();
-        listingTracePane->setListingTrace(sourceCodePane->getAssemblerListingList(), sourceCodePane->getHasCheckBox());
+    QStringList osListingList;
+    QList<bool> osHasCheckBox;
+    if (sourceCodePane->installDefaultOs(osListingList, osHasCheckBox)) {
+        listingTracePane->setListingTrace(osListingList, osHasCheckBox);
         ui->statusbar->showMessage("OS installed", 4000);
     }
     else {
@@ -276,6 +285,10 @@ bool MainWindow::maybeSaveObject()
 
 void MainWindow::loadFile(const QString &fileName)
 {
+    if (ObjectFile::isObjectFileName(fileName)) {
+        loadFileBinaryObject(fileName);
+        return;
+    }
     QFile file(fileName);
     if (!file.open(QFile::ReadOnly | QFile::Text)) {
         QMessageBox::warning(this, tr("Application"),
@@ -309,6 +322,56 @@ void MainWindow::loadFile(const QString &fileName)
     QApplication::restoreOverrideCursor();
 }
 
+void MainWindow::loadFileBinaryObject(const QString &fileName)
+{
+    if (!maybeSaveObject()) {
+        return;
+    }
+    QList<int> objectCode;
+    int loadAddress;
+    QStringList assemblerListingList;
+    QList<bool> hasCheckBox;
+    QString errorString;
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    Pep::memAddrssToAssemblerListing = &Pep::memAddrssToAssemblerListingProg;
+    Pep::listingRowChecked = &Pep::listingRowCheckedProg;
+    // Programs load at address 0, so an image for elsewhere, like the cached OS, is rejected.
+    if (!ObjectFile::read(fileName, objectCode, loadAddress, assemblerListingList, hasCheckBox,
+                          Pep::memAddrssToAssemblerListingProg, errorString, 0)) {
+        QApplication::restoreOverrideCursor();
+        QMessageBox::warning(this, tr("Application"),
+                             tr("Cannot read file %1:\n%2.")
+                             .arg(fileName)
+                             .arg(errorString));
+        return;
+    }
+    // The code objects of the last assembly refer to the symbol table the file replaced.
+    sourceCodePane->clearParsedLines();
+    objectCodePane->setObjectCode(objectCode);
+    programObjectCode = objectCode;
+    programListingList = assemblerListingList;
+    programHasCheckBox = hasCheckBox;
+    programAnnotationList.clear();
+    programCostSummaryList.clear();
+    programCrossReferences.clear();
+    programListingRowOfLine.clear();
+    programListingPending = false;
+    programAnnotationsPending = false;
+    if (assemblerListingList.isEmpty()) {
+        assemblerListingPane->clearAssemblerListing();
+        listingTracePane->clearListingTrace();
+    }
+    else {
+        assemblerListingPane->setAssemblerListing(assemblerListingList);
+        listingTracePane->setListingTrace(assemblerListingList, hasCheckBox);
+        memoryTracePane->setMemoryTrace();
+        listingTracePane->showAssemblerListing();
+    }
+    setCurrentFile(fileName, Enu::EObject);
+    QApplication::restoreOverrideCursor();
+    statusBar()->showMessage(tr("File loaded"), 4000);
+}
+
 bool MainWindow::saveFileSource(const QString &fileName)
 {
     QFile file(fileName);
@@ -333,6 +396,9 @@ bool MainWindow::saveFileSource(const QString &fileName)
 
 bool MainWindow::saveFileObject(const QString &fileName) // Copied and pasted, change.
 {
+    if (ObjectFile::isObjectFileName(fileName)) {
+        return saveFileBinaryObject(fileName);
+    }
     QFile file(fileName);
     if (!file.open(QFile::WriteOnly | QFile::Text)) {
         QMessageBox::warning(this, tr("Application"),
@@ -353,8 +419,42 @@ bool MainWindow::saveFileObject(const QString &fileName) // Copied and pasted, c
     return true;
 }
 
+bool MainWindow::saveFileBinaryObject(const QString &fileName)
+{
+    ensureProgramListing();
+    QList<int> objectCode;
+    QString errorString;
+    if (!objectCodePane->getObjectCode(objectCode)) {
+        errorString = "The object code is not valid";
+    }
+    else {
+        QApplication::setOverrideCursor(Qt::WaitCursor);
+        if (objectCode == programObjectCode) {
+            ObjectFile::write(fileName, objectCode, 0, programListingList, programHasCheckBox,
+                              Pep::memAddrssToAssemblerListingProg, true, errorString);
+        }
+        else {
+            // The listing and symbols describe other object code, so the image is saved alone.
+            ObjectFile::writeImage(fileName, objectCode, 0, errorString);
+        }
+        QApplication::restoreOverrideCursor();
+    }
+    if (!errorString.isEmpty()) {
+        QMessageBox::warning(this, tr("Application"),
+                             tr("Cannot write file %1:\n%2.")
+                             .arg(fileName)
+                             .arg(errorString));
+        return false;
+    }
+
+    setCurrentFile(fileName, Enu::EObject);
+    statusBar()->showMessage("Object code saved", 4000);
+    return true;
+}
+
 bool MainWindow::saveFileListing(const QString &fileName)
 {
+    ensureProgramListing();
     QFile file(fileName);
     if (!file.open(QFile::WriteOnly | QFile::Text)) {
         QMessageBox::warning(this, tr("Pep/8"),
@@ -450,74 +550,215 @@ void MainWindow::updateRecentFileActions()
 
 bool MainWindow::assemble()
 {
+    programListingPending = false;
     Pep::memAddrssToAssemblerListing = &Pep::memAddrssToAssemblerListingProg;
     Pep::listingRowChecked = &Pep::listingRowCheckedProg;
-    Pep::burnCount = 0;
     if (sourceCodePane->assemble()) {
-        if (Pep::burnCount > 0) {
-            QString errorString = ";ERROR: .BURN not allowed in program unless installing OS.";
-            sourceCodePane->appendMessageInSourceCodePaneAt(0, errorString);
-            assemblerListingPane->clearAssemblerListing();
-            objectCodePane->clearObjectCode();
-            listingTracePane->clearListingTrace();
-            ui->pepCodeTraceTab->setCurrentIndex(0); // Make source code pane visible
-            return false;
+        // The listing is formatted when it is first needed, so Run Source does not wait for it.
+        clearProgramListing();
+        programObjectCode = sourceCodePane->getObjectCode();
+        objectCodePane->setObjectCode(programObjectCode);
+        programListingPending = true;
+        memoryTracePane->setMemoryTrace();
+        listingTracePane->showAssemblerListing();
+
+        QString temp = curSourceFile;
+        if (!curSourceFile.isEmpty()) {
+            if (temp.endsWith(".pep", Qt::CaseInsensitive) || temp.endsWith(".txt", Qt::CaseInsensitive)) {
+                temp.chop(4);
+            }
+            temp.append(".pepo");
+            curObjectFile = temp;
+            setCurrentFile(curObjectFile, Enu::EObject);
+            temp.chop(5);
+            temp.append(".pepl");
+            curListingFile = temp;
+            setCurrentFile(curListingFile, Enu::EListing);
         }
         else {
-            objectCodePane->setObjectCode(sourceCodePane->getObjectCode());
-            assemblerListingPane->setAssemblerListing(sourceCodePane->getAssemblerListingList());
-            listingTracePane->setListingTrace(sourceCodePane->getAssemblerListingList(), sourceCodePane->getHasCheckBox());
-            memoryTracePane->setMemoryTrace();
-            listingTracePane->showAssemblerListing();
-
-            QString temp = curSourceFile;
-            if (!curSourceFile.isEmpty()) {
-                if (temp.endsWith(".pep", Qt::CaseInsensitive) || temp.endsWith(".txt", Qt::CaseInsensitive)) {
-                    temp.chop(4);
-                }
-                temp.append(".pepo");
-                curObjectFile = temp;
-                setCurrentFile(curObjectFile, Enu::EObject);
-                temp.chop(5);
-                temp.append(".pepl");
-                curListingFile = temp;
-                setCurrentFile(curListingFile, Enu::EListing);
-            }
-            else {
-                setCurrentFile("", Enu::EObject);
-                setCurrentFile("", Enu::EListing);
-            }
-            ui->actionEdit_Format_From_Listing->setEnabled(true);
-           if (!Pep::traceTagWarning && !(Pep::blockSymbols.isEmpty()
-                && Pep::equateSymbols.isEmpty()
-                && Pep::globalStructSymbols.isEmpty()
-                && Pep::symbolFormat.isEmpty()
-                && Pep::symbolFormatMultiplier.isEmpty())) {
-                memoryTracePane->show();
-            }
-            else {
-                memoryTracePane->hide();
-            }
-            ui->actionBuild_Start_Debugging_Source->setEnabled(true);
-            return true;
+            setCurrentFile("", Enu::EObject);
+            setCurrentFile("", Enu::EListing);
+        }
+        ui->actionEdit_Format_From_Listing->setEnabled(true);
+        if (!Pep::traceTagWarning && !(Pep::blockSymbols.isEmpty()
+            && Pep::equateSymbols.isEmpty()
+            && Pep::globalStructSymbols.isEmpty())) {
+            memoryTracePane->show();
         }
+        else {
+            memoryTracePane->hide();
+        }
+        ui->actionBuild_Start_Debugging_Source->setEnabled(true);
+        return true;
     }
-    assemblerListingPane->clearAssemblerListing();
+    clearProgramListing();
     objectCodePane->clearObjectCode();
-    listingTracePane->clearListingTrace();
     ui->pepCodeTraceTab->setCurrentIndex(0); // Make source code pane visible
     return false;
 }
 
+void MainWindow::clearProgramListing()
+{
+    assemblerListingPane->clearAssemblerListing();
+    listingTracePane->clearListingTrace();
+    programListingList.clear();
+    programHasCheckBox.clear();
+    programAnnotationList.clear();
+    programCostSummaryList.clear();
+    programCrossReferences.clear();
+    programListingRowOfLine.clear();
+    programListingPending = false;
+    programAnnotationsPending = false;
+    programObjectCode.clear();
+    Pep::memAddrssToAssemblerListingProg.clear();
+    Pep::listingRowCheckedProg.clear();
+}
+
+void MainWindow::ensureProgramListing()
+{
+    if (!programListingPending) {
+        return;
+    }
+    programListingPending = false;
+    QMap<int, int> *memAddrssToAssemblerListing = Pep::memAddrssToAssemblerListing;
+    QMap<int, Qt::CheckState> *listingRowChecked = Pep::listingRowChecked;
+    Pep::memAddrssToAssemblerListing = &Pep::memAddrssToAssemblerListingProg;
+    Pep::listingRowChecked = &Pep::listingRowCheckedProg;
+    programListingList = sourceCodePane->getAssemblerListingList();
+    programHasCheckBox = sourceCodePane->getHasCheckBox();
+    programListingRowOfLine = sourceCodePane->getListingRowOfLine();
+    programCrossReferences = Pep::crossReferenceIndex();
+    // The flow graph is only built when the annotations are shown.
+    programAnnotationList.clear();
+    programCostSummaryList.clear();
+    programAnnotationsPending = true;
+    if (ui->actionView_Cost_Annotations->isChecked()) {
+        computeProgramAnnotations();
+    }
+    showProgramListing();
+    listingTracePane->setListingTrace(programListingList, programHasCheckBox);
+    Pep::memAddrssToAssemblerListing = memAddrssToAssemblerListing;
+    Pep::listingRowChecked = listingRowChecked;
+}
+
+void MainWindow::computeProgramAnnotations()
+{
+    programAnnotationsPending = false;
+    QMap<int, QString> annotationOfAddress;
+    sourceCodePane->getCostAnnotations(annotationOfAddress, programCostSummaryList);
+    // A disassembly replaces the address map of the program until it is discarded.
+    const QMap<int, int> &addressToRow = disassembler.isEmpty() ? Pep::memAddrssToAssemblerListingProg
+                                                                : savedAddressToRow;
+    programAnnotationList.clear();
+    for (int i = 0; i < programListingList.size(); i++) {
+        programAnnotationList.append(QString(FlowGraph::annotationWidth, ' '));
+    }
+    QMapIterator<int, QString> it(annotationOfAddress);
+    while (it.hasNext()) {
+        it.next();
+        int row = addressToRow.value(it.key(), -1);
+        if (row >= 0 && row < programAnnotationList.size()) {
+            programAnnotationList[row] = it.value();
+        }
+    }
+}
+
+void MainWindow::showProgramListing()
+{
+    if (ui->actionView_Cost_Annotations->isChecked()) {
+        assemblerListingPane->setAssemblerListing(programListingList, programAnnotationList, programCostSummaryList);
+    }
+    else {
+        assemblerListingPane->setAssemblerListing(programListingList);
+    }
+    assemblerListingPane->setCrossReferences(programCrossReferences, programListingRowOfLine);
+}
+
+void MainWindow::disassemble(int entryAddress, int firstAddress, int endAddress)
+{
+    ensureProgramListing();
+    if (disassembler.isEmpty()) {
+        savedAddressToRow = Pep::memAddrssToAssemblerListingProg;
+    }
+    disassembler.disassemble(entryAddress, firstAddress, endAddress);
+    showDisassembly();
+}
+
+void MainWindow::discardDisassembly()
+{
+    if (disassembler.isEmpty()) {
+        return;
+    }
+    disassembler.clear();
+    Pep::memAddrssToAssemblerListingProg = savedAddressToRow;
+    Pep::listingRowCheckedProg.clear();
+    savedAddressToRow.clear();
+    QMap<int, int> *memAddrssToAssemblerListing = Pep::memAddrssToAssemblerListing;
+    QMap<int, Qt::CheckState> *listingRowChecked = Pep::listingRowChecked;
+    Pep::memAddrssToAssemblerListing = &Pep::memAddrssToAssemblerListingProg;
+    Pep::listingRowChecked = &Pep::listingRowCheckedProg;
+    listingTracePane->setListingTrace(programListingList, programHasCheckBox);
+    Pep::memAddrssToAssemblerListing = memAddrssToAssemblerListing;
+    Pep::listingRowChecked = listingRowChecked;
+}
+
+void MainWindow::showDisassembly()
+{
+    Pep::memAddrssToAssemblerListingProg = disassembler.getAddressToRow();
+    Pep::listingRowCheckedProg.clear();
+    QMap<int, int> *memAddrssToAssemblerListing = Pep::memAddrssToAssemblerListing;
+    QMap<int, Qt::CheckState> *listingRowChecked = Pep::listingRowChecked;
+    Pep::memAddrssToAssemblerListing = &Pep::memAddrssToAssemblerListingProg;
+    Pep::listingRowChecked = &Pep::listingRowCheckedProg;
+    listingTracePane->setListingTrace(disassembler.getListing(), disassembler.getHasCheckBox());
+    Pep::memAddrssToAssemblerListing = memAddrssToAssemblerListing;
+    Pep::listingRowChecked = listingRowChecked;
+}
+
 bool MainWindow::load()
 {
-    QList<int> objectCodeList;
-    if (objectCodePane->getObjectCode(objectCodeList)) {
-        Sim::loadMem(objectCodeList);
-        memoryDumpPane->refreshMemoryLines(0, objectCodeList.size());
-        return true;
-    }    
-    return false;
+    int byteCount;
+    int errorOffset;
+    bool ok = Sim::loadObjectCode(objectCodePane->toPlainText(), 0, byteCount, errorOffset);
+    loadedByteCount = byteCount;
+    memoryDumpPane->refreshMemoryLines(0, byteCount);
+    if (!ok) {
+        objectCodePane->setCursorPosition(errorOffset);
+    }
+    return ok;
+}
+
+void MainWindow::setupBatchIO()
+{
+    closeBatchIO();
+    if (!batchInputFile.fileName().isEmpty() && batchInputFile.open(QIODevice::ReadOnly)) {
+        Sim::inputBuffer.clear();
+        Sim::setInputDevice(&batchInputFile);
+    }
+    else {
+        QString s = inputPane->toPlainText();
+        if (!s.endsWith("\n")) {
+            s.append("\n");
+        }
+        Sim::inputBuffer = s;
+    }
+    if (!batchOutputFile.fileName().isEmpty()) {
+        if (batchOutputFile.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            Sim::outputDevice = &batchOutputFile;
+            outputPane->appendOutput("Output streamed to " + strippedName(batchOutputFile.fileName()) + "\n");
+        }
+        else {
+            ui->statusbar->showMessage("Cannot write file " + batchOutputFile.fileName(), 4000);
+        }
+    }
+}
+
+void MainWindow::closeBatchIO()
+{
+    Sim::setInputDevice(NULL);
+    Sim::outputDevice = NULL;
+    batchInputFile.close();
+    batchOutputFile.close();
 }
 
 void MainWindow::setDebugState(bool b)
@@ -534,8 +775,14 @@ void MainWindow::setDebugState(bool b)
     ui->actionBuild_Run_Object->setDisabled(b);
     ui->actionBuild_Start_Debugging_Object->setDisabled(b);
     ui->actionBuild_Start_Debugging_Loader->setDisabled(b);
+    ui->actionBuild_Assemble_Module->setDisabled(b);
+    ui->actionBuild_Link_Modules->setDisabled(b);
+    ui->actionBuild_Optimize_Source->setDisabled(b);
     ui->actionBuild_Stop_Debugging->setDisabled(!b);
     ui->actionBuild_Interrupt_Execution->setDisabled(!b);
+    ui->actionBuild_Step_Over->setDisabled(!b);
+    ui->actionBuild_Step_Out->setDisabled(!b);
+    ui->actionBuild_Run_To_Cursor->setDisabled(!b);
     ui->actionSystem_Clear_Memory->setDisabled(b);
     ui->actionSystem_Redefine_Mnemonics->setDisabled(b);
     ui->actionSystem_Assemble_Install_New_OS->setDisabled(b);
@@ -607,6 +854,14 @@ void MainWindow::on_actionFile_New_triggered()
         objectCodePane->clearObjectCode();
         assemblerListingPane->clearAssemblerListing();
         listingTracePane->clearListingTrace();
+        programListingList.clear();
+        programHasCheckBox.clear();
+        programAnnotationList.clear();
+        programCostSummaryList.clear();
+        programCrossReferences.clear();
+        programListingRowOfLine.clear();
+        programListingPending = false;
+        programAnnotationsPending = false;
         cpuPane->clearCpu();
         outputPane->clearOutput();
         ui->pepCodeTraceTab->setCurrentIndex(0);
@@ -624,7 +879,7 @@ void MainWindow::on_actionFile_Open_triggered()
                 this,
                 "Open text file",
                 curPath,
-                "Text files (*.pepo *.txt *.pep)");
+                "Pep8 files (*.pep *.pepo *.pepobj *.txt)");
         if (!fileName.isEmpty()) {
             loadFile(fileName);
             ui->pepCodeTraceTab->setCurrentIndex(0);
@@ -678,7 +933,7 @@ bool MainWindow::on_actionFile_Save_Object_As_triggered()
             this,
             "Save Object Code",
             curObjectFile.isEmpty() ? curPath + "/untitled.pepo" : curPath + "/" + strippedName(curObjectFile),
-            "Pep8 Object (*.pepo *.txt)");
+            "Pep8 Object (*.pepo *.txt);;Pep8 Binary Object with Debug Information (*.pepobj)");
     if (fileName.isEmpty())
         return false;
 
@@ -743,6 +998,7 @@ void MainWindow::on_actionFile_Print_Object_triggered()
 
 void MainWindow::on_actionFile_Print_Listing_triggered()
 {
+    ensureProgramListing();
     QTextDocument document(assemblerListingPane->toPlainText(), this);
     document.setDefaultFont(QFont("Courier", 10, -1));
 
@@ -885,10 +1141,56 @@ void MainWindow::on_actionEdit_Remove_Error_Messages_triggered()
     sourceCodePane->removeErrorMessages();
 }
 
+void MainWindow::on_actionEdit_Go_To_Definition_triggered()
+{
+    QString symbol;
+    bool found = assemblerListingPane->hasFocus() ? assemblerListingPane->goToDefinition(symbol)
+                                                  : sourceCodePane->goToDefinition(symbol);
+    if (symbol.isEmpty()) {
+        ui->statusbar->showMessage("No symbol at the cursor", 4000);
+    }
+    else if (!found) {
+        ui->statusbar->showMessage("No definition of " + symbol, 4000);
+    }
+}
+
+void MainWindow::on_actionEdit_Find_References_triggered()
+{
+    QString symbol;
+    int count = assemblerListingPane->hasFocus() ? assemblerListingPane->findReferences(symbol)
+                                                 : sourceCodePane->findReferences(symbol);
+    if (symbol.isEmpty()) {
+        ui->statusbar->showMessage("No symbol at the cursor", 4000);
+    }
+    else if (count < 0) {
+        ui->statusbar->showMessage("No references to " + symbol, 4000);
+    }
+    else {
+        ui->statusbar->showMessage(QString("%1 used on %2 line%3").arg(symbol).arg(count).arg(count == 1 ? "" : "s"), 4000);
+    }
+}
+
+void MainWindow::on_actionEdit_Unused_Symbols_triggered()
+{
+    Pep::CrossReferenceIndex index = assemblerListingPane->hasFocus() ? assemblerListingPane->getCrossReferenceIndex()
+                                                                      : sourceCodePane->getCrossReferenceIndex();
+    QStringList unused = Pep::unusedSymbols(index);
+    if (unused.isEmpty()) {
+        QMessageBox::information(this, "Pep/8", "Every defined symbol is used.");
+        return;
+    }
+    QStringList lines;
+    for (int i = 0; i < unused.size(); i++) {
+        lines.append(QString("%1 (line %2)").arg(unused.at(i)).arg(index.value(unused.at(i)).definitionLineNum + 1));
+    }
+    QMessageBox::information(this, "Pep/8", "Symbols defined but never used:\n\n" + lines.join("\n"));
+}
+
 // Build MainWindow triggers
 void MainWindow::on_actionBuild_Assemble_triggered()
 {
     if (assemble()) {
+        ensureProgramListing();
         ui->statusbar->showMessage("Assembly succeeded", 4000);
     }
     else {
@@ -919,11 +1221,7 @@ void MainWindow::on_actionBuild_Execute_triggered()
     if (ui->pepInputOutputTab->currentIndex() == 0) {
         ui->pepInputOutputTab->setTabEnabled(1, false);
         outputPane->clearOutput();
-        QString s = inputPane->toPlainText();
-        if (!s.endsWith("\n")) {
-            s.append("\n");
-        }
-        Sim::inputBuffer = s;
+        setupBatchIO();
         cpuPane->runWithBatch();
     }
     else {
@@ -944,6 +1242,7 @@ void MainWindow::on_actionBuild_Run_Source_triggered()
 
 void MainWindow::on_actionBuild_Start_Debugging_Source_triggered()
 {
+    ensureProgramListing();
     if (!assemblerListingPane->isEmpty() && load()) {
         ui->statusbar->showMessage("Load succeeded", 4000);
         Sim::stackPointer = Sim::readWord(Pep::dotBurnArgument - 7);
@@ -955,11 +1254,7 @@ void MainWindow::on_actionBuild_Start_Debugging_Source_triggered()
         if (ui->pepInputOutputTab->currentIndex() == 0) {
             ui->pepInputOutputTab->setTabEnabled(1, false);
             outputPane->clearOutput();
-            QString s = inputPane->toPlainText();
-            if (!s.endsWith("\n")) {
-                s.append("\n");
-            }
-            Sim::inputBuffer = s;
+            setupBatchIO();
         }
         else {
             ui->pepInputOutputTab->setTabEnabled(0, false);
@@ -1003,7 +1298,12 @@ void MainWindow::on_actionBuild_Run_Object_triggered()
 
 void MainWindow::on_actionBuild_Start_Debugging_Object_triggered()
 {
+    ensureProgramListing();
     if (load()) {
+        if (programListingList.isEmpty()) {
+            // There is no source for the object code, so list it from memory.
+            disassemble(0, 0, loadedByteCount);
+        }
         Sim::stackPointer = Sim::readWord(Pep::dotBurnArgument - 7);
         Sim::programCounter = 0x0000;
 
@@ -1016,11 +1316,7 @@ void MainWindow::on_actionBuild_Start_Debugging_Object_triggered()
         if (ui->pepInputOutputTab->currentIndex() == 0) {
             ui->pepInputOutputTab->setTabEnabled(1, false);
             outputPane->clearOutput();
-            QString s = inputPane->toPlainText();
-            if (!s.endsWith("\n")) {
-                s.append("\n");
-            }
-            Sim::inputBuffer = s;
+            setupBatchIO();
         }
         else {
             ui->pepInputOutputTab->setTabEnabled(0, false);
@@ -1046,6 +1342,9 @@ void MainWindow::on_actionBuild_Start_Debugging_Loader_triggered()
     Sim::programCounter = Sim::readWord(Pep::dotBurnArgument - 3);
     // 3 is the vector offset from the last byte of the OS for the Loader program counter
 
+    // The program is listed from memory as the loader stores it.
+    disassemble(0, 0, 0);
+
     Pep::memAddrssToAssemblerListing = &Pep::memAddrssToAssemblerListingOS;
     Pep::listingRowChecked = &Pep::listingRowCheckedOS;
     Sim::trapped = true;
@@ -1066,8 +1365,14 @@ void MainWindow::on_actionBuild_Start_Debugging_Loader_triggered()
     ui->actionBuild_Run_Object->setDisabled(true);
     ui->actionBuild_Start_Debugging_Object->setDisabled(true);
     ui->actionBuild_Start_Debugging_Loader->setDisabled(true);
+    ui->actionBuild_Assemble_Module->setDisabled(true);
+    ui->actionBuild_Link_Modules->setDisabled(true);
+    ui->actionBuild_Optimize_Source->setDisabled(true);
     ui->actionBuild_Stop_Debugging->setDisabled(false);
     ui->actionBuild_Interrupt_Execution->setDisabled(false);
+    ui->actionBuild_Step_Over->setDisabled(false);
+    ui->actionBuild_Step_Out->setDisabled(false);
+    ui->actionBuild_Run_To_Cursor->setDisabled(false);
     ui->actionEdit_Remove_Error_Messages->setDisabled(true);
     inputPane->setReadOnly(true);
     sourceCodePane->setReadOnly(true);
@@ -1083,8 +1388,165 @@ void MainWindow::on_actionBuild_Start_Debugging_Loader_triggered()
     cpuPane->updateCpu();
 }
 
+void MainWindow::on_actionBuild_Assemble_Module_triggered()
+{
+    Pep::memAddrssToAssemblerListing = &Pep::memAddrssToAssemblerListingProg;
+    Pep::listingRowChecked = &Pep::listingRowCheckedProg;
+    bool assembled = sourceCodePane->assemble(Enu::EModule);
+    // The module replaced the symbol table and address map of the program, so the program
+    // listing no longer describes the object code pane.
+    clearProgramListing();
+    if (!assembled) {
+        ui->pepCodeTraceTab->setCurrentIndex(0); // Make source code pane visible
+        ui->statusbar->showMessage("Assembly failed", 4000);
+        return;
+    }
+    assemblerListingPane->setAssemblerListing(sourceCodePane->getAssemblerListingList());
+    assemblerListingPane->setCrossReferences(Pep::crossReferenceIndex(), sourceCodePane->getListingRowOfLine());
+
+    QString moduleFile = curSourceFile.isEmpty() ? "untitled.pep" : strippedName(curSourceFile);
+    if (moduleFile.endsWith(".pep", Qt::CaseInsensitive) || moduleFile.endsWith(".txt", Qt::CaseInsensitive)) {
+        moduleFile.chop(4);
+    }
+    QString fileName = QFileDialog::getSaveFileName(
+            this,
+            "Save Module",
+            curPath + "/" + moduleFile + ".pepmod",
+            "Pep8 Relocatable Module (*.pepmod)");
+    if (fileName.isEmpty()) {
+        return;
+    }
+    QList<int> relocationOffsets;
+    QStringList relocationSymbols;
+    sourceCodePane->getRelocations(relocationOffsets, relocationSymbols);
+    QString errorString;
+    if (!ObjectFile::writeModule(fileName, sourceCodePane->getObjectCode(), relocationOffsets, relocationSymbols,
+                                 errorString)) {
+        QMessageBox::warning(this, tr("Pep/8"),
+                             tr("Cannot write file %1:\n%2.")
+                             .arg(fileName)
+                             .arg(errorString));
+        return;
+    }
+    curPath = QFileInfo(fileName).path();
+    ui->statusbar->showMessage("Module saved", 4000);
+}
+
+void MainWindow::on_actionBuild_Link_Modules_triggered()
+{
+    if (!maybeSaveObject()) {
+        return;
+    }
+    QStringList fileNames = QFileDialog::getOpenFileNames(
+            this,
+            "Link Modules",
+            curPath,
+            "Pep8 Relocatable Modules (*.pepmod)");
+    if (fileNames.isEmpty()) {
+        return;
+    }
+    QList<int> objectCode;
+    QString errorString;
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    bool linked = Linker::link(fileNames, objectCode, errorString);
+    QApplication::restoreOverrideCursor();
+    if (!linked) {
+        QMessageBox::warning(this, tr("Pep/8"), tr("Link failed:\n%1").arg(errorString));
+        ui->statusbar->showMessage("Link failed", 4000);
+        return;
+    }
+    curPath = QFileInfo(fileNames.first()).path();
+    objectCodePane->setObjectCode(objectCode);
+    clearProgramListing();
+    setCurrentFile("", Enu::EObject);
+    ui->statusbar->showMessage("Link succeeded", 4000);
+}
+
+void MainWindow::on_actionBuild_Optimize_Source_triggered()
+{
+    ensureProgramListing();
+    QStringList sourceCodeList = sourceCodePane->toPlainText().split('\n');
+    QStringList optimizedList;
+    Peephole::Report report;
+    QList<int> objectCodeBefore;
+    QList<int> objectCodeAfter;
+    QString errorString;
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    bool optimized = Peephole::optimize(sourceCodeList, optimizedList, report, objectCodeBefore, objectCodeAfter,
+                                        errorString);
+    QString dynamicReport;
+    if (optimized) {
+        // Run both versions on the batch input to measure the instructions saved.
+        // As in setupBatchIO, the input comes from the batch input file if one is chosen.
+        const int maxSteps = 10000000;
+        int instructionsBefore;
+        int instructionsAfter;
+        QFile inputFile(batchInputFile.fileName());
+        QIODevice *inputDevice = NULL;
+        QString input;
+        if (!inputFile.fileName().isEmpty() && inputFile.open(QIODevice::ReadOnly)) {
+            inputDevice = &inputFile;
+        }
+        else {
+            input = inputPane->toPlainText();
+            if (!input.endsWith("\n")) {
+                input.append("\n");
+            }
+        }
+        if (!Peephole::countInstructions(objectCodeBefore, inputDevice, input, maxSteps, instructionsBefore, errorString)
+            || !Peephole::countInstructions(objectCodeAfter, inputDevice, input, maxSteps, instructionsAfter, errorString)) {
+            dynamicReport = QString("Instructions executed: not measured. %1").arg(errorString);
+        }
+        else {
+            dynamicReport = QString("Instructions executed with the batch input: %1 before, %2 after, %3 saved")
+                            .arg(instructionsBefore).arg(instructionsAfter).arg(instructionsBefore - instructionsAfter);
+        }
+    }
+    QApplication::restoreOverrideCursor();
+    // The optimizer assembled over the symbol table, so assemble the source pane again.
+    if (!optimized) {
+        assemble();
+        QMessageBox::warning(this, tr("Pep/8"), tr("Optimization failed:\n%1").arg(errorString));
+        ui->statusbar->showMessage("Optimization failed", 4000);
+        return;
+    }
+
+    QString text = QString("Branches to the next instruction removed: %1\n"
+                           "Stack adjustments combined: %2\n"
+                           "Reloads after a store removed: %3\n"
+                           "Branches to a branch shortened: %4\n\n"
+                           "Object code: %5 bytes before, %6 after, %7 saved\n%8")
+                   .arg(report.branchesToNextRemoved)
+                   .arg(report.stackAdjustmentsCombined)
+                   .arg(report.reloadsRemoved)
+                   .arg(report.branchesThreaded)
+                   .arg(report.bytesBefore)
+                   .arg(report.bytesAfter)
+                   .arg(report.bytesBefore - report.bytesAfter)
+                   .arg(dynamicReport);
+    if (!report.sizeChangesAllowed) {
+        text.append("\n\nRules that remove code were skipped because the program uses numeric addresses.");
+    }
+    if (optimizedList == sourceCodeList) {
+        assemble();
+        QMessageBox::information(this, tr("Peephole Optimization"), text);
+        ui->statusbar->showMessage("Nothing to optimize", 4000);
+        return;
+    }
+    text.append("\n\nReplace the source code with the optimized program?");
+    if (QMessageBox::question(this, tr("Peephole Optimization"), text, QMessageBox::Yes | QMessageBox::No)
+        == QMessageBox::Yes) {
+        sourceCodePane->setSourceCodePaneText(optimizedList.join("\n"));
+    }
+    if (assemble()) {
+        ensureProgramListing();
+    }
+    ui->statusbar->showMessage("Optimization complete", 4000);
+}
+
 void MainWindow::on_actionBuild_Stop_Debugging_triggered()
 {
+    ensureProgramListing();
     cpuPane->interruptExecution();
     cpuPane->updateCpu();
     listingTracePane->updateListingTrace();
@@ -1102,15 +1564,19 @@ void MainWindow::on_actionBuild_Stop_Debugging_triggered()
         }
     }
     setDebugState(false);
+    discardDisassembly();
+    cpuPane->clearTemporaryBreakpoint();
     listingTracePane->setDebuggingState(false);
     cpuPane->setButtonsEnabled(false);
     memoryDumpPane->highlightMemory(false);
+    closeBatchIO();
 
     mainWindowUtilities(0, 0);
 }
 
 void MainWindow::on_actionBuild_Interrupt_Execution_triggered()
 {
+    ensureProgramListing();
     cpuPane->interruptExecution();
     setDebugState(true);
     cpuPane->updateCpu();
@@ -1122,6 +1588,79 @@ void MainWindow::on_actionBuild_Interrupt_Execution_triggered()
     listingTracePane->updateListingTrace();
 }
 
+void MainWindow::on_actionBuild_Step_Over_triggered()
+{
+    if (cpuPane->isSimulating()) {
+        return;
+    }
+    if (cpuPane->setStepOverBreakpoint()) {
+        resumeSimulation();
+    }
+    else {
+        singleStepButtonClicked();
+    }
+}
+
+void MainWindow::on_actionBuild_Step_Out_triggered()
+{
+    if (cpuPane->isSimulating()) {
+        return;
+    }
+    cpuPane->setStepOutBreakpoint();
+    resumeSimulation();
+}
+
+void MainWindow::on_actionBuild_Run_To_Cursor_triggered()
+{
+    if (cpuPane->isSimulating()) {
+        return;
+    }
+    int address = listingTracePane->cursorAddress();
+    if (address == -1) {
+        ui->statusbar->showMessage("Select an instruction in the listing trace to run to", 4000);
+        return;
+    }
+    cpuPane->setRunToCursorBreakpoint(address);
+    resumeSimulation();
+}
+
+void MainWindow::on_actionBuild_Batch_Input_From_File_triggered(bool checked)
+{
+    QString fileName;
+    if (checked) {
+        fileName = QFileDialog::getOpenFileName(this, "Batch Input File", curPath, "All files (*)");
+    }
+    batchInputFile.setFileName(fileName);
+    ui->actionBuild_Batch_Input_From_File->setChecked(!fileName.isEmpty());
+    if (!fileName.isEmpty()) {
+        ui->statusbar->showMessage("Batch input from " + strippedName(fileName), 4000);
+    }
+    else {
+        ui->statusbar->showMessage("Batch input from input pane", 4000);
+    }
+}
+
+void MainWindow::on_actionBuild_Batch_Output_To_File_triggered(bool checked)
+{
+    QString fileName;
+    if (checked) {
+        fileName = QFileDialog::getSaveFileName(this, "Batch Output File", curPath, "All files (*)");
+    }
+    batchOutputFile.setFileName(fileName);
+    ui->actionBuild_Batch_Output_To_File->setChecked(!fileName.isEmpty());
+    if (!fileName.isEmpty()) {
+        ui->statusbar->showMessage("Batch output to " + strippedName(fileName), 4000);
+    }
+    else {
+        ui->statusbar->showMessage("Batch output to output pane", 4000);
+    }
+}
+
+void MainWindow::on_actionBuild_Native_Loader_triggered(bool checked)
+{
+    cpuPane->setNativeLoaderEnabled(checked);
+}
+
 // View MainWindow triggers
 void MainWindow::on_actionView_Code_Only_triggered()
 {
@@ -1196,6 +1735,16 @@ void MainWindow::on_actionView_Terminal_Tab_triggered()
     }
 }
 
+void MainWindow::on_actionView_Cost_Annotations_triggered()
+{
+    if (ui->actionView_Cost_Annotations->isChecked() && programAnnotationsPending) {
+        computeProgramAnnotations();
+    }
+    if (!programAnnotationList.isEmpty()) {
+        showProgramListing();
+    }
+}
+
 // System MainWindow triggers
 
 void MainWindow::on_actionSystem_Clear_Memory_triggered()
@@ -1209,50 +1758,38 @@ void MainWindow::on_actionSystem_Clear_Memory_triggered()
 
 void MainWindow::on_actionSystem_Redefine_Mnemonics_triggered()
 {
+    // The background check reads the mnemonic tables that the dialog changes.
+    sourceCodePane->setBackgroundAssemblyEnabled(false);
+    ensureProgramListing();
+    programAnnotationsPending = false; // The code list of the program is cleared
+    sourceCodePane->clearParsedLines();
     redefineMnemonicsDialog->show();
 }
 
+void MainWindow::redefineMnemonicsDialogFinished()
+{
+    // Lines parsed while the dialog was open may use mnemonics it has since changed.
+    ensureProgramListing();
+    programAnnotationsPending = false; // The code list of the program is cleared
+    sourceCodePane->clearParsedLines();
+    sourceCodePane->setBackgroundAssemblyEnabled(true);
+}
+
 void MainWindow::on_actionSystem_Assemble_Install_New_OS_triggered()
 {
-    Pep::burnCount = 0;
+    ensureProgramListing();
+    programObjectCode.clear(); // The symbol table is replaced by that of the OS
+    programAnnotationsPending = false; // and the code list by the code of the OS
     Pep::memAddrssToAssemblerListing = &Pep::memAddrssToAssemblerListingOS;
     Pep::listingRowChecked = &Pep::listingRowCheckedOS;
-    if (sourceCodePane->assemble()) {
-        if (Pep::burnCount == 0) {
-            QString errorString = ";ERROR: .BURN required to install OS.";
-            sourceCodePane->appendMessageInSourceCodePaneAt(0, errorString);
-            assemblerListingPane->clearAssemblerListing();
-            objectCodePane->clearObjectCode();
-            listingTracePane->clearListingTrace();
-            ui->statusbar->showMessage("Assembly failed", 4000);
-        }
-        else if (Pep::burnCount > 1) {
-            QString errorString = ";ERROR: Program contain more than one .BURN.";
-            sourceCodePane->appendMessageInSourceCodePaneAt(0, errorString);
-            assemblerListingPane->clearAssemblerListing();
-            objectCodePane->clearObjectCode();
-            listingTracePane->clearListingTrace();
-            ui->statusbar->showMessage("Assembly failed", 4000);
-        }
-        else {
-            // Adjust for .BURN
-            int addressDelta = Pep::dotBurnArgument - Pep::byteCount + 1;
-            QMutableMapIterator <QString, int> i(Pep::symbolTable);
-            while (i.hasNext()) {
-                i.next();
-                if (Pep::adjustSymbolValueForBurn.value(i.key())) {
-                    i.setValue(i.value() + addressDelta);
-                }
-            }
-            sourceCodePane->adjustCodeList(addressDelta);
-            Pep::romStartAddress += addressDelta;
-            objectCodePane->setObjectCode(sourceCodePane->getObjectCode());
-            assemblerListingPane->setAssemblerListing(sourceCodePane->getAssemblerListingList());
-            listingTracePane->setListingTrace(sourceCodePane->getAssemblerListingList(), sourceCodePane->getHasCheckBox());
-            sourceCodePane->installOS();
-            memoryDumpPane->refreshMemory();
-            ui->statusbar->showMessage("Assembly succeeded, OS installed", 4000);
-        }
+    if (sourceCodePane->assemble(Enu::EOperatingSystem)) {
+        objectCodePane->setObjectCode(sourceCodePane->getObjectCode());
+        assemblerListingPane->setAssemblerListing(sourceCodePane->getAssemblerListingList());
+        assemblerListingPane->setCrossReferences(Pep::crossReferenceIndex(), sourceCodePane->getListingRowOfLine());
+        listingTracePane->setListingTrace(sourceCodePane->getAssemblerListingList(), sourceCodePane->getHasCheckBox());
+        sourceCodePane->installOS();
+        memoryDumpPane->refreshMemory();
+        ui->statusbar->showMessage("Assembly succeeded, OS installed", 4000);
     }
     else {
         assemblerListingPane->clearAssemblerListing();
@@ -1264,11 +1801,15 @@ void MainWindow::on_actionSystem_Assemble_Install_New_OS_triggered()
 
 void MainWindow::on_actionSystem_Reinstall_Default_OS_triggered()
 {
+    ensureProgramListing();
+    programObjectCode.clear(); // The symbol table is replaced by that of the OS
+    programAnnotationsPending = false; // and the code list by the code of the OS
     Pep::memAddrssToAssemblerListing = &Pep::memAddrssToAssemblerListingOS;
     Pep::listingRowChecked = &Pep::listingRowCheckedOS;
-    if (sourceCodePane->installDefaultOs()) {
-        sourceCodePane->getAssemblerListingList();
-        listingTracePane->setListingTrace(sourceCodePane->getAssemblerListingList(), sourceCodePane->getHasCheckBox());
+    QStringList osListingList;
+    QList<bool> osHasCheckBox;
+    if (sourceCodePane->installDefaultOs(osListingList, osHasCheckBox)) {
+        listingTracePane->setListingTrace(osListingList, osHasCheckBox);
         ui->statusbar->showMessage("OS installed", 4000);
     }
     else {
@@ -1361,6 +1902,8 @@ void MainWindow::helpCopyToSourceButtonClicked()
             assemblerListingPane->clearAssemblerListing();
             objectCodePane->clearObjectCode();
             listingTracePane->clearListingTrace();
+            programListingPending = false;
+            programAnnotationsPending = false;
             statusBar()->showMessage("Copied to source", 4000);
             ui->actionBuild_Start_Debugging_Source->setEnabled(false);
         }
@@ -1371,6 +1914,8 @@ void MainWindow::helpCopyToSourceButtonClicked()
         sourceCodePane->clearSourceCode();
         assemblerListingPane->clearAssemblerListing();
         listingTracePane->clearListingTrace();
+        programListingPending = false;
+        programAnnotationsPending = false;
         statusBar()->showMessage("Copied to object", 4000);
         ui->actionBuild_Start_Debugging_Source->setEnabled(false);
     }
@@ -1621,6 +2166,10 @@ void MainWindow::doubleClickedCodeLabel(Enu::EPane pane)
 
 void MainWindow::updateSimulationView()
 {
+    ensureProgramListing();
+    if (disassembler.update()) {
+        showDisassembly();
+    }
     listingTracePane->updateListingTrace();
     if (!memoryTracePane->isHidden()) {
         memoryTracePane->updateMemoryTrace();
@@ -1633,6 +2182,7 @@ void MainWindow::updateSimulationView()
 
 void MainWindow::vonNeumannStepped()
 {
+    disassembler.memoryWritten(Sim::modifiedBytes);
     memoryDumpPane->cacheModifiedBytes();
     if (!memoryTracePane->isHidden()) {
         memoryTracePane->cacheChanges();
@@ -1661,6 +2211,7 @@ void MainWindow::openRecentFile()
 
 void MainWindow::waitingForInput()
 {
+    ensureProgramListing();
     terminalPane->waitingForInput();
     mainWindowUtilities(0, 0);
 }
@@ -1681,6 +2232,12 @@ void MainWindow::inputReceived()
 }
 
 void MainWindow::resumeButtonClicked()
+{
+    cpuPane->clearTemporaryBreakpoint();
+    resumeSimulation();
+}
+
+void MainWindow::resumeSimulation()
 {
     if (ui->pepInputOutputTab->currentIndex() == 0) { // batch input
         cpuPane->resumeWithBatch();
@@ -1692,6 +2249,7 @@ void MainWindow::resumeButtonClicked()
 
 void MainWindow::singleStepButtonClicked()
 {
+    cpuPane->clearTemporaryBreakpoint();
     if (ui->pepInputOutputTab->currentIndex() == 0) { // batch input
         cpuPane->singleStepWithBatch();
     }
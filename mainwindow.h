@@ -23,6 +23,7 @@
 #define MAINWINDOW_H
 
 #include <QtGui/QMainWindow>
+#include <QFile>
 #include "byteconverterdec.h"
 #include "byteconverterhex.h"
 #include "byteconverterbin.h"
@@ -47,6 +48,7 @@
 
 // Dialog boxes
 #include "redefinemnemonicsdialog.h"
+#include "disassembler.h"
 #include "helpdialog.h"
 #include "aboutpep.h"
 
@@ -106,8 +108,10 @@ private:
     bool maybeSaveSource();
     bool maybeSaveObject();
     void loadFile(const QString &fileName);
+    void loadFileBinaryObject(const QString &fileName);
     bool saveFileSource(const QString &fileName);
     bool saveFileObject(const QString &fileName);
+    bool saveFileBinaryObject(const QString &fileName);
     bool saveFileListing(const QString &fileName);
     void setCurrentFile(const QString &fileName, Enu::EPane pane);
     QString strippedName(const QString &fullFileName);
@@ -117,6 +121,57 @@ private:
     QString curListingFile;
     QString curPath;
 
+    // Listing of the last assembled program, saved in binary object files
+    QStringList programListingList;
+    QList<bool> programHasCheckBox;
+    bool programListingPending; // The program is assembled but its listing is not formatted yet
+    QList<int> programObjectCode; // Object code that the listing and symbol table describe, if any
+
+    // Cost annotations of the listing rows of the last assembled program and its cost summary
+    QStringList programAnnotationList;
+    QStringList programCostSummaryList;
+    bool programAnnotationsPending; // The program listing is formatted but its annotations are not computed yet
+    Pep::CrossReferenceIndex programCrossReferences;
+    QList<int> programListingRowOfLine;
+
+    // Listing decoded from memory for a program that has no assembler listing
+    Disassembler disassembler;
+    int loadedByteCount; // Bytes of object code stored by the last load
+    QMap<int, int> savedAddressToRow; // Program address map replaced by the disassembly
+
+    void disassemble(int entryAddress, int firstAddress, int endAddress);
+    // Post: The program is disassembled from entryAddress and shown by showDisassembly. The program
+    // address map is saved first if no disassembly is shown yet.
+
+    void showDisassembly();
+    // Post: The disassembly is displayed in the program listing of the listing trace pane, and
+    // the program break points and address map are those of the disassembly.
+
+    void discardDisassembly();
+    // Post: If a disassembly is shown, it is cleared, and the program address map and listing
+    // trace it replaced are restored. The listing trace is restored without break points.
+
+    void clearProgramListing();
+    // Post: The program listing, its annotations, cross references, address map and break points
+    // are cleared from the main window and the listing panes, and no object code is described.
+
+    void ensureProgramListing();
+    // Post: If the listing of the last assembled program is pending, it is formatted from the code
+    // list of the source code pane into programListingList, the assembler listing pane and the
+    // listing trace pane. Its cost annotations are computed if they are turned on in the View menu.
+
+    void computeProgramAnnotations();
+    // Pre: programListingList is the listing of the code list of the source code pane.
+    // Post: programAnnotationList and programCostSummaryList are the cost annotations of the
+    // flow graph of the program.
+
+    void resumeSimulation();
+    // Post: The simulation resumes with batch or terminal input, whichever tab is selected
+
+    void showProgramListing();
+    // Post: programListingList is displayed in the assembler listing pane, with its cost
+    // annotations if they are turned on in the View menu.
+
     // Recent Files methods
     void updateRecentFileActions();
     enum { MaxRecentFiles = 5};
@@ -126,6 +181,19 @@ private:
     bool assemble();
     bool load();
 
+    // Streaming batch I/O files
+    QFile batchInputFile;
+    QFile batchOutputFile;
+
+    void setupBatchIO();
+    // Pre: The batch I/O tab is selected.
+    // Post: If a batch input file is selected, it is opened and streamed to the simulator.
+    // Otherwise, Sim::inputBuffer is filled from the input pane.
+    // Post: If a batch output file is selected, it is opened and the simulator writes to it.
+
+    void closeBatchIO();
+    // Post: The batch input and output files are closed and detached from the simulator.
+
     void setDebugState(bool b);
 
     bool eventFilter(QObject *, QEvent *event);
@@ -151,6 +219,9 @@ private slots:
     void on_actionEdit_Format_From_Listing_triggered();
     void on_actionEdit_Font_triggered();
     void on_actionEdit_Remove_Error_Messages_triggered();
+    void on_actionEdit_Go_To_Definition_triggered();
+    void on_actionEdit_Find_References_triggered();
+    void on_actionEdit_Unused_Symbols_triggered();
 
     // Build
     void on_actionBuild_Assemble_triggered();
@@ -161,8 +232,17 @@ private slots:
     void on_actionBuild_Run_Object_triggered();
     void on_actionBuild_Start_Debugging_Object_triggered();
     void on_actionBuild_Start_Debugging_Loader_triggered();
+    void on_actionBuild_Assemble_Module_triggered();
+    void on_actionBuild_Link_Modules_triggered();
+    void on_actionBuild_Optimize_Source_triggered();
     void on_actionBuild_Stop_Debugging_triggered();
     void on_actionBuild_Interrupt_Execution_triggered();
+    void on_actionBuild_Step_Over_triggered();
+    void on_actionBuild_Step_Out_triggered();
+    void on_actionBuild_Run_To_Cursor_triggered();
+    void on_actionBuild_Batch_Input_From_File_triggered(bool checked);
+    void on_actionBuild_Batch_Output_To_File_triggered(bool checked);
+    void on_actionBuild_Native_Loader_triggered(bool checked);
 
     // View
     void on_actionView_Code_Only_triggered();
@@ -172,6 +252,7 @@ private slots:
     void on_actionView_Trace_Tab_triggered();
     void on_actionView_Batch_I_O_Tab_triggered();
     void on_actionView_Terminal_Tab_triggered();
+    void on_actionView_Cost_Annotations_triggered();
 
     // System
     void on_actionSystem_Clear_Memory_triggered();
@@ -193,6 +274,7 @@ private slots:
     void on_actionAbout_Qt_triggered();
 
     void helpCopyToSourceButtonClicked();
+    void redefineMnemonicsDialogFinished();
 
     // Byte converter
     void slotByteConverterDecEdited(const QString &);
@@ -46,12 +46,31 @@ MemoryCellGraphicsItem::MemoryCellGraphicsItem(int addr, QString sym,  Enu::ESym
 }
 
 QRectF MemoryCellGraphicsItem::boundingRect() const
+{
+    return boundingRectAt(x, y);
+}
+
+QRectF MemoryCellGraphicsItem::boundingRectAt(int xLoc, int yLoc)
 {
     const int Margin = 4;
-    return QRectF(QPointF(x - addressWidth - Margin, y - Margin),
+    return QRectF(QPointF(xLoc - addressWidth - Margin, yLoc - Margin),
                   QSizeF(addressWidth + bufferWidth * 2 + boxWidth + symbolWidth + Margin * 2, boxHeight + Margin * 2));
 }
 
+void MemoryCellGraphicsItem::reset(int addr, QString sym, Enu::ESymbolFormat eSymFrmt, int xLoc, int yLoc)
+{
+    prepareGeometryChange();
+    x = xLoc;
+    y = yLoc;
+    address = addr;
+    symbol = sym;
+    eSymbolFormat = eSymFrmt;
+    boxColor = Qt::black;
+    boxBgColor = Qt::white;
+    textColor = Qt::black;
+    boxTextColor = Qt::black;
+}
+
 void MemoryCellGraphicsItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *, QWidget *)
 {
     QPen pen(boxColor);
@@ -94,6 +113,7 @@ void MemoryCellGraphicsItem::updateValue()
         value = ""; // Should not occur
         break;
     }
+    update();
 }
 
 int MemoryCellGraphicsItem::getAddress()
@@ -33,6 +33,12 @@ public:
 
     QRectF boundingRect() const;
 
+    static QRectF boundingRectAt(int xLoc, int yLoc);
+    // Post: The bounding rect of a cell drawn at xLoc, yLoc is returned.
+
+    void reset(int addr, QString sym, Enu::ESymbolFormat eSymFrmt, int xLoc, int yLoc);
+    // Post: The item shows the cell at addr as if it was newly constructed, so it can be reused.
+
     void paint(QPainter *painter, const QStyleOptionGraphicsItem *, QWidget *);
 
     static const int boxHeight;
@@ -48,6 +54,7 @@ public:
     QColor textColor;
     QColor boxTextColor;
     void updateValue();
+    // Post: value is read from memory and the item is scheduled for repainting.
     int getAddress();
     int getNumBytes();
 
@@ -0,0 +1,103 @@
+// File: memorydumpmodel.cpp
+/*
+    Pep8-1 is a virtual machine for writing machine language and assembly
+    language programs.
+    
+    Copyright (C) 2009  J. Stanley Warford, Pepperdine University
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "memorydumpmodel.h"
+#include "sim.h"
+
+MemoryDumpModel::MemoryDumpModel(QObject *parent) :
+    QAbstractTableModel(parent)
+{
+}
+
+int MemoryDumpModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : RowCount;
+}
+
+int MemoryDumpModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : CharColumn + 1;
+}
+
+QVariant MemoryDumpModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid()) {
+        return QVariant();
+    }
+    int firstByte = index.row() * BytesPerRow;
+    int column = index.column();
+    if (role == Qt::DisplayRole) {
+        if (column == AddressColumn) {
+            return QString("%1 |").arg(firstByte, 4, 16, QLatin1Char('0')).toUpper();
+        }
+        if (column == CharColumn) {
+            QString chars = "|";
+            for (int j = 0; j < BytesPerRow; j++) {
+                QChar ch = QChar(Sim::Mem[firstByte + j]);
+                chars.append(ch.isPrint() ? ch : QChar('.'));
+            }
+            return chars;
+        }
+        return QString("%1").arg(Sim::Mem[firstByte + column - FirstByteColumn], 2, 16, QLatin1Char('0')).toUpper();
+    }
+    if (column < FirstByteColumn || column >= CharColumn) {
+        return QVariant();
+    }
+    QHash<int, QPair<QColor, QColor> >::const_iterator it = highlights.constFind(firstByte + column - FirstByteColumn);
+    if (it == highlights.constEnd()) {
+        return QVariant();
+    }
+    if (role == Qt::ForegroundRole) {
+        return it.value().first;
+    }
+    if (role == Qt::BackgroundRole) {
+        return it.value().second;
+    }
+    return QVariant();
+}
+
+QModelIndex MemoryDumpModel::indexOfByte(int address) const
+{
+    return index(address / BytesPerRow, FirstByteColumn + address % BytesPerRow);
+}
+
+void MemoryDumpModel::refreshBytes(int firstByte, int lastByte)
+{
+    emit dataChanged(index(firstByte / BytesPerRow, AddressColumn), index(lastByte / BytesPerRow, CharColumn));
+}
+
+void MemoryDumpModel::highlightByte(int address, QColor foreground, QColor background)
+{
+    highlights.insert(address, qMakePair(foreground, background));
+    QModelIndex cell = indexOfByte(address);
+    emit dataChanged(cell, cell);
+}
+
+void MemoryDumpModel::clearHighlights()
+{
+    QList<int> addresses = highlights.keys();
+    highlights.clear();
+    for (int i = 0; i < addresses.size(); i++) {
+        QModelIndex cell = indexOfByte(addresses.at(i));
+        emit dataChanged(cell, cell);
+    }
+}
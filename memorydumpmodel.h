@@ -0,0 +1,64 @@
+// File: memorydumpmodel.h
+/*
+    Pep8-1 is a virtual machine for writing machine language and assembly
+    language programs.
+    
+    Copyright (C) 2009  J. Stanley Warford, Pepperdine University
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef MEMORYDUMPMODEL_H
+#define MEMORYDUMPMODEL_H
+
+#include <QAbstractTableModel>
+#include <QColor>
+#include <QHash>
+#include <QPair>
+
+// Table model of the memory dump. Each row is eight bytes of Sim::Mem: an address column,
+// one column per byte and a character column. Cells are formatted from memory when the view
+// asks for them, so only the visible rows are ever formatted.
+class MemoryDumpModel : public QAbstractTableModel
+{
+    Q_OBJECT
+public:
+    enum { BytesPerRow = 8, RowCount = 65536 / BytesPerRow };
+    enum { AddressColumn = 0, FirstByteColumn = 1, CharColumn = FirstByteColumn + BytesPerRow };
+
+    explicit MemoryDumpModel(QObject *parent = 0);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const;
+
+    QModelIndex indexOfByte(int address) const;
+    // Post: The index of the cell of the byte at address is returned.
+
+    void refreshBytes(int firstByte, int lastByte);
+    // Post: The views are told that the rows from the one containing firstByte to the one
+    // containing lastByte changed.
+
+    void highlightByte(int address, QColor foreground, QColor background);
+    // Post: The byte at address is drawn in foreground on background.
+
+    void clearHighlights();
+    // Post: No byte is highlighted.
+
+private:
+    QHash<int, QPair<QColor, QColor> > highlights; // Foreground and background by address
+};
+
+#endif // MEMORYDUMPMODEL_H
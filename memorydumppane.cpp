@@ -19,8 +19,9 @@
     along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 #include <QFontDialog>
-#include <QTextCharFormat>
-#include <QAbstractTextDocumentLayout>
+#include <QApplication>
+#include <QClipboard>
+#include <QHeaderView>
 #include "memorydumppane.h"
 #include "ui_memorydumppane.h"
 #include "sim.h"
@@ -35,10 +36,20 @@ MemoryDumpPane::MemoryDumpPane(QWidget *parent) :
 {
     ui->setupUi(this);
 
+    memoryDumpModel = new MemoryDumpModel(this);
+    ui->tableView->setModel(memoryDumpModel);
+    ui->tableView->horizontalHeader()->hide();
+    ui->tableView->verticalHeader()->hide();
+    ui->tableView->horizontalHeader()->setResizeMode(QHeaderView::Fixed);
+    ui->tableView->verticalHeader()->setResizeMode(QHeaderView::Fixed);
+
     if (Pep::getSystem() != "Mac") {
         ui->label->setFont(QFont(Pep::labelFont, Pep::labelFontSize));
-        ui->textEdit->setFont(QFont(Pep::codeFont, Pep::codeFontSize));
+        ui->tableView->setFont(QFont(Pep::codeFont, Pep::codeFontSize));
     }
+    resizeCells();
+
+    delayLastStepClear = false;
 
     connect(ui->pcPushButton, SIGNAL(clicked()), this, SLOT(scrollToPC()));
     connect(ui->spPushButton, SIGNAL(clicked()), this, SLOT(scrollToSP()));
@@ -52,130 +63,25 @@ MemoryDumpPane::~MemoryDumpPane()
 
 void MemoryDumpPane::refreshMemory()
 {
-    QStringList memoryDump;
-    QString memoryDumpLine;
-    QChar ch;
-    for (int i = 0; i < 65536; i += 8) {
-        memoryDumpLine = "";
-        memoryDumpLine.append(QString("%1 | ").arg(i, 4, 16, QLatin1Char('0')).toUpper());
-        for (int j = 0; j < 8; j++) {
-            memoryDumpLine.append(QString("%1 ").arg(Sim::Mem[i + j], 2, 16, QLatin1Char('0')).toUpper());
-        }
-        memoryDumpLine.append("|");
-        for (int j = 0; j < 8; j++) {
-            ch = QChar(Sim::Mem[i + j]);
-            if (ch.isPrint()) {
-                memoryDumpLine.append(ch);
-            } else {
-                memoryDumpLine.append(".");
-            }
-        }
-        memoryDump.append(memoryDumpLine);
-    }
-    ui->textEdit->setText(memoryDump.join("\n"));
+    memoryDumpModel->refreshBytes(0, 65535);
 }
 
 void MemoryDumpPane::refreshMemoryLines(int firstByte, int lastByte)
 {
-    int vertScrollBarPosition = ui->textEdit->verticalScrollBar()->value();
-    int horizScrollBarPosition = ui->textEdit->horizontalScrollBar()->value();
-
-    int firstLine = firstByte / 8;
-    int lastLine = lastByte / 8;
-
-    QTextCursor cursor(ui->textEdit->document());
-    cursor.setPosition(0);
-    for (int i = 0; i < firstLine; i++) {
-        cursor.movePosition(QTextCursor::NextBlock);
-    }
-
-    QString memoryDumpLine;
-    QChar ch;
-    int byteNum;
-    for (int i = firstLine; i <= lastLine; i++) {
-        memoryDumpLine = "";
-        byteNum = i * 8;
-        memoryDumpLine.append(QString("%1 | ").arg(byteNum, 4, 16, QLatin1Char('0')).toUpper());
-        for (int j = 0; j < 8; j++) {
-            memoryDumpLine.append(QString("%1 ").arg(Sim::Mem[byteNum++], 2, 16, QLatin1Char('0')).toUpper());
-        }
-        memoryDumpLine.append("|");
-        byteNum = i * 8;
-        for (int j = 0; j < 8; j++) {
-            ch = QChar(Sim::Mem[byteNum++]);
-            if (ch.isPrint()) {
-                memoryDumpLine.append(ch);
-            } else {
-                memoryDumpLine.append(".");
-            }
-        }
-        cursor.movePosition(QTextCursor::EndOfLine, QTextCursor::KeepAnchor);
-        ui->textEdit->setTextCursor(cursor);
-        ui->textEdit->insertPlainText(memoryDumpLine);
-        cursor.movePosition(QTextCursor::NextBlock);
-    }
-
-    ui->textEdit->verticalScrollBar()->setValue(vertScrollBarPosition);
-    ui->textEdit->horizontalScrollBar()->setValue(horizScrollBarPosition);
+    memoryDumpModel->refreshBytes(firstByte, lastByte);
 }
 
 void MemoryDumpPane::highlightMemory(bool b)
 {
-    while (!highlightedData.isEmpty()) {
-        highlightByte(highlightedData.takeFirst(), Qt::black, Qt::white);
-    }
+    memoryDumpModel->clearHighlights();
 
     if (b) {
-        highlightByte(Sim::stackPointer, Qt::white, Qt::darkMagenta);
-        highlightedData.append(Sim::stackPointer);
-        
+        memoryDumpModel->highlightByte(Sim::stackPointer, Qt::white, Qt::darkMagenta);
+
+        memoryDumpModel->highlightByte(Sim::programCounter, Qt::white, Qt::blue);
         if (!Pep::isUnaryMap.value(Pep::decodeMnemonic.value(Sim::readByte(Sim::programCounter)))) {
-            QTextCursor cursor(ui->textEdit->document());
-            QTextCharFormat format;
-            format.setBackground(Qt::blue);
-            format.setForeground(Qt::white);
-            cursor.setPosition(0);
-            for (int i = 0; i < Sim::programCounter / 8; i++) {
-                cursor.movePosition(QTextCursor::NextBlock);
-            }
-            for (int i = 0; i < 7 + 3 * (Sim::programCounter % 8); i++) {
-                cursor.movePosition(QTextCursor::NextCharacter);
-            }
-            cursor.movePosition(QTextCursor::NextCharacter, QTextCursor::KeepAnchor, 2);
-            cursor.mergeCharFormat(format);
-            highlightedData.append(Sim::programCounter);
-            if (Sim::programCounter / 8 == (Sim::programCounter + 1) / 8) {
-                cursor.clearSelection();
-                cursor.movePosition(QTextCursor::NextCharacter);
-                cursor.movePosition(QTextCursor::NextCharacter, QTextCursor::KeepAnchor, 2);
-                cursor.mergeCharFormat(format);
-            }
-            else {
-                cursor.clearSelection();
-                cursor.movePosition(QTextCursor::NextBlock);
-                cursor.movePosition(QTextCursor::NextCharacter, QTextCursor::MoveAnchor, 7);
-                cursor.movePosition(QTextCursor::NextCharacter, QTextCursor::KeepAnchor, 2);
-                cursor.mergeCharFormat(format);
-            }
-            highlightedData.append(Sim::add(Sim::programCounter, 1));
-            if ((Sim::programCounter + 1) / 8 == (Sim::programCounter + 2) / 8) {
-                cursor.clearSelection();
-                cursor.movePosition(QTextCursor::NextCharacter);
-                cursor.movePosition(QTextCursor::NextCharacter, QTextCursor::KeepAnchor, 2);
-                cursor.mergeCharFormat(format);
-            }
-            else {
-                cursor.clearSelection();
-                cursor.movePosition(QTextCursor::NextBlock);
-                cursor.movePosition(QTextCursor::NextCharacter, QTextCursor::MoveAnchor, 7);
-                cursor.movePosition(QTextCursor::NextCharacter, QTextCursor::KeepAnchor, 2);
-                cursor.mergeCharFormat(format);
-            }
-            highlightedData.append(Sim::add(Sim::programCounter, 2));
-        }
-        else { // unary.
-            highlightByte(Sim::programCounter, Qt::white, Qt::blue);
-            highlightedData.append(Sim::programCounter);
+            memoryDumpModel->highlightByte(Sim::add(Sim::programCounter, 1), Qt::white, Qt::blue);
+            memoryDumpModel->highlightByte(Sim::add(Sim::programCounter, 2), Qt::white, Qt::blue);
         }
 
         bytesWrittenLastStep = bytesWrittenLastStep.toSet().toList();
@@ -183,8 +89,7 @@ void MemoryDumpPane::highlightMemory(bool b)
         while (!bytesWrittenLastStep.isEmpty()) {
             // This is to prevent bytes modified by the OS from being highlighted when we are not tracing traps:
             if (bytesWrittenLastStep.at(0) < Sim::readWord(Pep::dotBurnArgument - 0x7) || Sim::trapped) {
-                highlightByte(bytesWrittenLastStep.at(0), Qt::white, Qt::red);
-                highlightedData.append(bytesWrittenLastStep.takeFirst());
+                memoryDumpModel->highlightByte(bytesWrittenLastStep.takeFirst(), Qt::white, Qt::red);
             }
             else {
                 return;
@@ -215,71 +120,29 @@ void MemoryDumpPane::cacheModifiedBytes()
 
 void MemoryDumpPane::updateMemory()
 {
-    int vertScrollBarPosition = ui->textEdit->verticalScrollBar()->value();
-    int horizScrollBarPosition = ui->textEdit->horizontalScrollBar()->value();
-
-    QList<int> list;
     QSet<int> linesToBeUpdated;
-    QString memoryDumpLine;
-    QChar ch;
-    int byteNum;
-    int lineNum;
-
     modifiedBytes.unite(Sim::modifiedBytes);
-    list = modifiedBytes.toList();
-    while(!list.isEmpty()) {
-        linesToBeUpdated.insert(list.takeFirst() / 8);
+    QSetIterator<int> it(modifiedBytes);
+    while (it.hasNext()) {
+        linesToBeUpdated.insert(it.next() / MemoryDumpModel::BytesPerRow);
     }
-    list = linesToBeUpdated.toList();
-    qSort(list.begin(), list.end());
-    QTextCursor cursor(ui->textEdit->document());
-    cursor.setPosition(0);
-    lineNum = 0;
-    while (!list.isEmpty()) {
-        while (lineNum < list.first()) {
-            cursor.movePosition(QTextCursor::NextBlock);
-            lineNum++;
-        }
-
-        memoryDumpLine = "";
-        byteNum = lineNum * 8;
-        memoryDumpLine.append(QString("%1 | ").arg(byteNum, 4, 16, QLatin1Char('0')).toUpper());
-        for (int j = 0; j < 8; j++) {
-            memoryDumpLine.append(QString("%1 ").arg(Sim::Mem[byteNum++], 2, 16, QLatin1Char('0')).toUpper());
-        }
-        memoryDumpLine.append("|");
-        byteNum = lineNum * 8;
-        for (int j = 0; j < 8; j++) {
-            ch = QChar(Sim::Mem[byteNum++]);
-            if (ch.isPrint()) {
-                memoryDumpLine.append(ch);
-            } else {
-                memoryDumpLine.append(".");
-            }
-        }
-        cursor.movePosition(QTextCursor::EndOfLine, QTextCursor::KeepAnchor);
-        ui->textEdit->setTextCursor(cursor);
-        ui->textEdit->insertPlainText(memoryDumpLine);
-        cursor.movePosition(QTextCursor::NextBlock);
-        lineNum++;
-        list.removeFirst();
+    QSetIterator<int> lines(linesToBeUpdated);
+    while (lines.hasNext()) {
+        int firstByte = lines.next() * MemoryDumpModel::BytesPerRow;
+        memoryDumpModel->refreshBytes(firstByte, firstByte);
     }
     modifiedBytes.clear();
-
-    ui->textEdit->verticalScrollBar()->setValue(vertScrollBarPosition);
-    ui->textEdit->horizontalScrollBar()->setValue(horizScrollBarPosition);
-
 }
 
 void MemoryDumpPane::scrollToTop()
 {
-    ui->textEdit->verticalScrollBar()->setValue(0);
-    ui->textEdit->horizontalScrollBar()->setValue(0);
+    ui->tableView->verticalScrollBar()->setValue(0);
+    ui->tableView->horizontalScrollBar()->setValue(0);
 }
 
 void MemoryDumpPane::highlightOnFocus()
 {
-    if (ui->textEdit->hasFocus() || ui->scrollToLineEdit->hasFocus()) {
+    if (ui->tableView->hasFocus() || ui->scrollToLineEdit->hasFocus()) {
         ui->label->setAutoFillBackground(true);
     }
     else {
@@ -289,56 +152,71 @@ void MemoryDumpPane::highlightOnFocus()
 
 bool MemoryDumpPane::hasFocus()
 {
-    return ui->textEdit->hasFocus() || ui->scrollToLineEdit->hasFocus();
+    return ui->tableView->hasFocus() || ui->scrollToLineEdit->hasFocus();
 }
 
 void MemoryDumpPane::copy()
 {
-    ui->textEdit->copy();
+    QModelIndexList indexes = ui->tableView->selectionModel()->selectedIndexes();
+    if (indexes.isEmpty()) {
+        return;
+    }
+    qSort(indexes);
+    QStringList lines;
+    QString line;
+    int row = indexes.first().row();
+    for (int i = 0; i < indexes.size(); i++) {
+        if (indexes.at(i).row() != row) {
+            lines.append(line);
+            line = "";
+            row = indexes.at(i).row();
+        }
+        if (!line.isEmpty()) {
+            line.append(" ");
+        }
+        line.append(memoryDumpModel->data(indexes.at(i)).toString());
+    }
+    lines.append(line);
+    QApplication::clipboard()->setText(lines.join("\n"));
 }
 
 void MemoryDumpPane::setFont()
 {
     bool ok = false;
-    QFont font = QFontDialog::getFont(&ok, QFont(ui->textEdit->font()), this, "Set Memory Dump Font");
+    QFont font = QFontDialog::getFont(&ok, QFont(ui->tableView->font()), this, "Set Memory Dump Font");
     if (ok) {
-        ui->textEdit->setFont(font);
+        ui->tableView->setFont(font);
+        resizeCells();
     }
 }
 
 int MemoryDumpPane::memoryDumpWidth()
 {
-    return ui->textEdit->document()->documentLayout()->documentSize().toSize().width() +
-            ui->textEdit->verticalScrollBar()->width() + 6;
+    return ui->tableView->horizontalHeader()->length() + 2 * ui->tableView->frameWidth() +
+            ui->tableView->verticalScrollBar()->width() + 6;
 }
 
-void MemoryDumpPane::highlightByte(int memAddr, QColor foreground, QColor background)
+void MemoryDumpPane::resizeCells()
 {
-    QTextCursor cursor(ui->textEdit->document());
-    cursor.setPosition(0);
-    for (int i = 0; i < memAddr / 8; i++) {
-        cursor.movePosition(QTextCursor::NextBlock);
-    }
-    for (int i = 0; i < 7 + 3 * (memAddr % 8); i++) {
-        cursor.movePosition(QTextCursor::NextCharacter);
+    // Every row has the same layout, so the cells are sized from the font alone.
+    QFontMetrics metrics(ui->tableView->font());
+    int padding = metrics.width(' ');
+    ui->tableView->setColumnWidth(MemoryDumpModel::AddressColumn, metrics.width("0000 |") + padding);
+    for (int j = 0; j < MemoryDumpModel::BytesPerRow; j++) {
+        ui->tableView->setColumnWidth(MemoryDumpModel::FirstByteColumn + j, metrics.width("00") + padding);
     }
-    cursor.movePosition(QTextCursor::NextCharacter, QTextCursor::KeepAnchor, 2);
-    QTextCharFormat format;
-    format.setBackground(background);
-    format.setForeground(foreground);
-    cursor.mergeCharFormat(format);
+    ui->tableView->setColumnWidth(MemoryDumpModel::CharColumn, metrics.width("|WWWWWWWW") + padding);
+    ui->tableView->verticalHeader()->setDefaultSectionSize(metrics.height() + 2);
 }
 
 void MemoryDumpPane::mouseReleaseEvent(QMouseEvent *)
 {
-    ui->textEdit->setFocus();
+    ui->tableView->setFocus();
 }
 
 void MemoryDumpPane::scrollToByte(int byte)
 {
-    int min = ui->textEdit->verticalScrollBar()->minimum();
-    int max = ui->textEdit->verticalScrollBar()->maximum();
-    ui->textEdit->verticalScrollBar()->setValue(min + static_cast<int>(8 * (byte / 4096 - 8) + ((byte - byte % 8) / 65536.0) * (max - min)));
+    ui->tableView->scrollTo(memoryDumpModel->indexOfByte(byte), QAbstractItemView::PositionAtTop);
 }
 
 void MemoryDumpPane::scrollToPC()
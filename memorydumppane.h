@@ -25,6 +25,7 @@
 #include <QtGui/QWidget>
 #include <QScrollBar>
 #include <QSet>
+#include "memorydumpmodel.h"
 
 namespace Ui {
     class MemoryDumpPane;
@@ -63,24 +64,23 @@ public:
     // Post: returns if the pane has focus
 
     void copy();
-    // Post: selected text in the text edit is copied to the clipboard
+    // Post: the selected cells of the memory dump are copied to the clipboard, one line per row
 
     void setFont();
-    // Post: the font used by the text edit is set to a font chosen in a font dialog
+    // Post: the font used by the memory dump is set to a font chosen in a font dialog
 
     int memoryDumpWidth();
-    // Post: the width of the memory dump text edit document is returned
+    // Post: the width of the memory dump table is returned
 
 private:
     Ui::MemoryDumpPane *ui;
 
-    void highlightByte(int memAddr, QColor foreground, QColor background);
-    // Used to highlight/unhighlight individual bytes.
+    MemoryDumpModel *memoryDumpModel;
 
-    void mouseReleaseEvent(QMouseEvent *);
+    void resizeCells();
+    // Post: The column widths and row height of the memory dump fit its font.
 
-    QList<int> highlightedData;
-    // This is a list of bytes that are currently highlighted.
+    void mouseReleaseEvent(QMouseEvent *);
 
     QSet<int> modifiedBytes;
     // This is a list of bytes that were modified since the last update. This is cached for a convenient time to update
@@ -20,6 +20,7 @@
 */
 #include <QFontDialog>
 #include <QRgb>
+#include <QScrollBar>
 #include "memorytracepane.h"
 #include "ui_memorytracepane.h"
 #include "pep.h"
@@ -41,10 +42,25 @@ MemoryTracePane::MemoryTracePane(QWidget *parent) :
     connect(ui->spinBox, SIGNAL(valueChanged(int)), this, SLOT(zoomFactorChanged(int)));
 
     scene = new QGraphicsScene(this);
+
+    for (int region = 0; region < ERegionCount; region++) {
+        addressToItem[region] = QVector<MemoryCellGraphicsItem *>(65536, NULL);
+    }
+    delayLastStepClear = false;
+    firstMaterializedCell = 0;
+    lastMaterializedCell = -1;
+    firstMaterializedFrame = 0;
+    lastMaterializedFrame = -1;
+    newAddress = -1;
+    heapPointerAddress = -1;
+
+    connect(ui->graphicsView->verticalScrollBar(), SIGNAL(valueChanged(int)), this, SLOT(materializeStack()));
 }
 
 MemoryTracePane::~MemoryTracePane()
 {
+    qDeleteAll(cellPool);
+    qDeleteAll(framePool);
     delete ui;
 }
 
@@ -53,21 +69,24 @@ void MemoryTracePane::setMemoryTrace()
     globalVars.clear();
     runtimeStack.clear();
     heap.clear();
-    isRuntimeStackItemAddedStack.clear();
     isHeapItemAddedStack.clear();
-    isStackFrameAddedStack.clear();
     isHeapFrameAddedStack.clear();
-    stackHeightToStackFrameMap.clear();
+    stackFrames.clear();
+    firstMaterializedCell = 0;
+    lastMaterializedCell = -1;
+    firstMaterializedFrame = 0;
+    lastMaterializedFrame = -1;
     modifiedBytes.clear();
     bytesWrittenLastStep.clear();
-    addressToGlobalItemMap.clear();
-    addressToStackItemMap.clear();
-    addressToHeapItemMap.clear();
-    numCellsInStackFrame.clear();
-    graphicItemsInStackFrame.clear();
+    for (int region = 0; region < ERegionCount; region++) {
+        addressToItem[region].fill(NULL);
+    }
+    highlightedCells.clear();
     heapFrameItemStack.clear();
     newestHeapItemsList.clear();
     scene->clear();
+    newAddress = Pep::isSymbolDefined("new") ? Pep::symbolValue("new") : -1;
+    heapPointerAddress = Pep::isSymbolDefined("hpPtr") ? Pep::symbolValue("hpPtr") : -1;
 
     if (Pep::traceTagWarning) {
         hide();
@@ -82,25 +101,31 @@ void MemoryTracePane::setMemoryTrace()
 
     // Globals:
     for (int i = 0; i < Pep::blockSymbols.size(); i++) {
-        blockSymbol = Pep::blockSymbols.at(i);
-        multiplier = Pep::symbolFormatMultiplier.value(blockSymbol);
-        int address = Pep::symbolTable.value(blockSymbol);
+        const Pep::Symbol &block = Pep::symbols.at(Pep::blockSymbols.at(i));
+        blockSymbol = block.name;
+        multiplier = block.formatMultiplier;
+        int address = block.value;
         if (Pep::globalStructSymbols.contains(blockSymbol)) {
             int offset = 0;
             int bytesPerCell;
             QString structField = "";
             for (int j = 0; j < Pep::globalStructSymbols.value(blockSymbol).size(); j++) {
                 structField = Pep::globalStructSymbols.value(blockSymbol).at(j);
-                bytesPerCell = Sim::cellSize(Pep::symbolFormat.value(structField));
+                int fieldId = Pep::symbolId(structField);
+                if (fieldId < 0) {
+                    continue;
+                }
+                Enu::ESymbolFormat fieldFormat = Pep::symbols.at(fieldId).format;
+                bytesPerCell = Sim::cellSize(fieldFormat);
                 MemoryCellGraphicsItem *item = new MemoryCellGraphicsItem(address + offset,
                                                                           QString("%1.%2").arg(blockSymbol).arg(structField),
-                                                                          Pep::symbolFormat.value(structField),
+                                                                          fieldFormat,
                                                                           static_cast<int>(globalLocation.x()),
                                                                           static_cast<int>(globalLocation.y()));
                 item->updateValue();
                 globalLocation = QPointF(globalLocation.x(), globalLocation.y() + MemoryCellGraphicsItem::boxHeight);
                 globalVars.push(item);
-                addressToGlobalItemMap.insert(address + offset, item);
+                indexCell(EGlobalRegion, item);
                 scene->addItem(item);
                 offset += bytesPerCell;
             }
@@ -109,28 +134,28 @@ void MemoryTracePane::setMemoryTrace()
             if (multiplier == 1) {
                 MemoryCellGraphicsItem *item = new MemoryCellGraphicsItem(address,
                                                                           blockSymbol,
-                                                                          Pep::symbolFormat.value(blockSymbol),
+                                                                          block.format,
                                                                           static_cast<int>(globalLocation.x()),
                                                                           static_cast<int>(globalLocation.y()));
                 item->updateValue();
                 globalLocation = QPointF(globalLocation.x(), globalLocation.y() + MemoryCellGraphicsItem::boxHeight);
                 globalVars.push(item);
-                addressToGlobalItemMap.insert(address, item);
+                indexCell(EGlobalRegion, item);
                 scene->addItem(item);
             }
             else { // Array
                 int offset = 0;
-                int bytesPerCell = Sim::cellSize(Pep::symbolFormat.value(blockSymbol));
+                int bytesPerCell = Sim::cellSize(block.format);
                 for (int j = 0; j < multiplier; j++) {
                     MemoryCellGraphicsItem *item = new MemoryCellGraphicsItem(address + offset,
                                                                               blockSymbol + QString("[%1]").arg(j),
-                                                                              Pep::symbolFormat.value(blockSymbol),
+                                                                              block.format,
                                                                               static_cast<int>(globalLocation.x()),
                                                                               static_cast<int>(globalLocation.y()));
                     item->updateValue();
                     globalLocation = QPointF(globalLocation.x(), globalLocation.y() + MemoryCellGraphicsItem::boxHeight);
                     globalVars.push(item);
-                    addressToGlobalItemMap.insert(address + offset, item);
+                    indexCell(EGlobalRegion, item);
                     scene->addItem(item);
                     offset += bytesPerCell;
                 }
@@ -153,7 +178,8 @@ void MemoryTracePane::setMemoryTrace()
 
     heapLocation.setY(globalLocation.y() - MemoryCellGraphicsItem::boxHeight);
     
-    scene->setSceneRect(scene->itemsBoundingRect());
+    baseSceneRect = scene->itemsBoundingRect();
+    scene->setSceneRect(baseSceneRect);
     ui->graphicsView->setScene(scene);
 
     ui->warningLabel->clear();
@@ -163,100 +189,59 @@ void MemoryTracePane::setMemoryTrace()
 
 void MemoryTracePane::updateMemoryTrace()
 {
-    // Color all of the cells normally (globals)
-    for (int i = 0; i < globalVars.size(); i++) {
-        globalVars.at(i)->boxBgColor = Qt::white;
-        globalVars.at(i)->boxTextColor = Qt::black;
-    }
-    // Color all of the cells normally (stack)
-    for (int i = 0; i < runtimeStack.size(); i++) {
-        runtimeStack.at(i)->boxBgColor = Qt::white;
-        runtimeStack.at(i)->boxTextColor = Qt::black;
-    }
-    // Color all of the cells normally (heap)
-    for (int i = 0; i < heap.size(); i++) {
-        heap.at(i)->boxBgColor = Qt::white;
-        heap.at(i)->boxTextColor = Qt::black;
+    // Color the cells highlighted by the last update normally
+    for (int i = 0; i < highlightedCells.size(); i++) {
+        highlightedCells.at(i)->boxBgColor = Qt::white;
+        highlightedCells.at(i)->boxTextColor = Qt::black;
+        highlightedCells.at(i)->update();
     }
+    highlightedCells.clear();
     // Color the newest 'new' items on the heap light green
     for (int i = 0; i < newestHeapItemsList.size(); i++) {
-        newestHeapItemsList.at(i)->boxBgColor = QColor(72, 255, 72, 192);
+        highlightCell(newestHeapItemsList.at(i), QColor(72, 255, 72, 192), Qt::black);
     }
     newestHeapItemsList.clear();
 
-    // Add cached stack items to the scene
-    for (int i = 0; i < runtimeStack.size(); i++) {
-        if (!isRuntimeStackItemAddedStack.at(i)) {
-            scene->addItem(runtimeStack.at(i));
-            isRuntimeStackItemAddedStack[i] = true;
-        }
+    // Add cached heap items to the scene
+    for (int i = isHeapItemAddedStack.size() - 1; i >= 0 && !isHeapItemAddedStack.at(i); i--) {
+        scene->addItem(heap.at(i));
+        isHeapItemAddedStack[i] = true;
     }
-    // Add cached stack FRAME items to the scene
-    for (int i = 0; i < isStackFrameAddedStack.size(); i++) {
-        if (!isStackFrameAddedStack.at(i)) {
-            scene->addItem(graphicItemsInStackFrame.at(i));
-            isStackFrameAddedStack[i] = true;
-        }
+    for (int i = isHeapFrameAddedStack.size() - 1; i >= 0 && !isHeapFrameAddedStack.at(i); i--) {
+        scene->addItem(heapFrameItemStack.at(i));
+        isHeapFrameAddedStack[i] = true;
     }
 
-    // Add cached heap items to the scene
-    for (int i = 0; i < isHeapItemAddedStack.size(); i++) {
-        if (!isHeapItemAddedStack.at(i)) {
-            scene->addItem(heap.at(i));
-            isHeapItemAddedStack[i] = true;
-        }
-    }
-    for (int i = 0; i < isHeapFrameAddedStack.size(); i++) {
-        if (!isHeapFrameAddedStack.at(i)) {
-            scene->addItem(heapFrameItemStack.at(i));
-            isHeapFrameAddedStack[i] = true;
-        }
+    updateSceneRect();
+    // Scroll to the top item if we have a scrollbar, then give the stack cells around the
+    // viewport their items before they are colored.
+    if (!runtimeStack.isEmpty() && ui->graphicsView->viewport()->height() < scene->height()) {
+        const StackCell &top = runtimeStack.last();
+        ui->graphicsView->centerOn(top.x + MemoryCellGraphicsItem::boxWidth / 2,
+                                   top.y + MemoryCellGraphicsItem::boxHeight / 2);
     }
+    materializeStack();
 
     // Color global/stack/heap items red if they were modified last step
-    QList<int> modifiedBytesToBeUpdated = modifiedBytes.toList();
     for (int i = 0; i < bytesWrittenLastStep.size(); i++) {
-        if (addressToGlobalItemMap.contains(bytesWrittenLastStep.at(i))) {
-            addressToGlobalItemMap.value(bytesWrittenLastStep.at(i))->boxBgColor = Qt::red;
-            addressToGlobalItemMap.value(bytesWrittenLastStep.at(i))->boxTextColor = Qt::white;
-        }
-        if (addressToStackItemMap.contains(bytesWrittenLastStep.at(i))) {
-            addressToStackItemMap.value(bytesWrittenLastStep.at(i))->boxBgColor = Qt::red;
-            addressToStackItemMap.value(bytesWrittenLastStep.at(i))->boxTextColor = Qt::white;
-        }
-        if (addressToHeapItemMap.contains(bytesWrittenLastStep.at(i))) {
-            addressToHeapItemMap.value(bytesWrittenLastStep.at(i))->boxBgColor = Qt::red;
-            addressToHeapItemMap.value(bytesWrittenLastStep.at(i))->boxTextColor = Qt::white;
+        int address = bytesWrittenLastStep.at(i);
+        for (int region = 0; region < ERegionCount; region++) {
+            if (MemoryCellGraphicsItem *item = addressToItem[region].at(address)) {
+                highlightCell(item, Qt::red, Qt::white);
+            }
         }
     }
     // Update modified cells
-    for (int i = 0; i < modifiedBytesToBeUpdated.size(); i++) {
-        if (addressToGlobalItemMap.contains(modifiedBytesToBeUpdated.at(i))) {
-            addressToGlobalItemMap.value(modifiedBytesToBeUpdated.at(i))->updateValue();
-        }
-        if (addressToStackItemMap.contains(modifiedBytesToBeUpdated.at(i))) {
-            addressToStackItemMap.value(modifiedBytesToBeUpdated.at(i))->updateValue();
-        }
-        if (addressToHeapItemMap.contains(modifiedBytesToBeUpdated.at(i))) {
-            addressToHeapItemMap.value(modifiedBytesToBeUpdated.at(i))->updateValue();
+    QSetIterator<int> it(modifiedBytes);
+    while (it.hasNext()) {
+        int address = it.next();
+        for (int region = 0; region < ERegionCount; region++) {
+            if (MemoryCellGraphicsItem *item = addressToItem[region].at(address)) {
+                item->updateValue();
+            }
         }
     }
-
-    scene->setSceneRect(scene->itemsBoundingRect());
-    // This is time-consuming, but worthwhile to ensure scrollbars aren't going off into oblivion after items are removed.
-    // From the documentation for the 'itemsBoundingRect()' function:
-    //  Calculates and returns the bounding rect of all items on the scene.
-    //  This function works by iterating over all items, and because if this, it can be slow for large scenes.
-    // Our it is unlikely that this scene become very large (as in the 30,000 chips example), so I would expect this to remain
-    // a reasonable function call. It is also called in the 'setMemoryTrace' function, but the scene will have very few items at that point.
-
-    scene->invalidate(); // redraw the scene!
-    // this is fast, so we do this for the whole scene instead of just certain boxes
-
-    // Scroll to the top item if we have a scrollbar:
-    if (!runtimeStack.isEmpty() && ui->graphicsView->viewport()->height() < scene->height()) {
-        ui->graphicsView->centerOn(runtimeStack.top());
-    }
+    // Only the cells changed above are repainted, each through its own update().
 
     // Clear modified bytes so for the next update:
     bytesWrittenLastStep.clear();
@@ -326,14 +311,7 @@ void MemoryTracePane::cacheStackChanges()
     switch (Pep::decodeMnemonic[Sim::instructionSpecifier]) {
     case Enu::CALL:
         {
-            MemoryCellGraphicsItem *item = new MemoryCellGraphicsItem(Sim::stackPointer, "retAddr", Enu::F_2H,
-                                                                      static_cast<int>(stackLocation.x()), static_cast<int>(stackLocation.y()));
-            item->updateValue();
-            stackLocation.setY(stackLocation.y() - MemoryCellGraphicsItem::boxHeight);
-
-            isRuntimeStackItemAddedStack.push(false);
-            runtimeStack.push(item);
-            addressToStackItemMap.insert(Sim::stackPointer, item);
+            pushStackCell(Sim::stackPointer, "retAddr", Enu::F_2H);
             frameSizeToAdd = stackFrameFSM.makeTransition(1);
         }
         break;
@@ -341,35 +319,23 @@ void MemoryTracePane::cacheStackChanges()
         {
             for (int i = 0; i < lookAheadSymbolList.size(); i++) {
                 stackSymbol = lookAheadSymbolList.at(i);
-                multiplier = Pep::symbolFormatMultiplier.value(stackSymbol);
+                int stackId = Pep::symbolId(stackSymbol);
+                if (stackId < 0) {
+                    continue;
+                }
+                const Pep::Symbol &stackTag = Pep::symbols.at(stackId);
+                multiplier = stackTag.formatMultiplier;
                 if (multiplier == 1) {
-                    offset += Sim::cellSize(Pep::symbolFormat.value(stackSymbol));
-                    MemoryCellGraphicsItem *item = new MemoryCellGraphicsItem(Sim::stackPointer - offset + Sim::operandSpecifier,
-                                                                              stackSymbol,
-                                                                              Pep::symbolFormat.value(stackSymbol),
-                                                                              static_cast<int>(stackLocation.x()),
-                                                                              static_cast<int>(stackLocation.y()));
-                    item->updateValue();
-                    stackLocation.setY(stackLocation.y() - MemoryCellGraphicsItem::boxHeight);
-                    isRuntimeStackItemAddedStack.push(false);
-                    runtimeStack.push(item);
-                    addressToStackItemMap.insert(Sim::stackPointer - offset + Sim::operandSpecifier, item);
+                    offset += Sim::cellSize(stackTag.format);
+                    pushStackCell(Sim::stackPointer - offset + Sim::operandSpecifier, stackSymbol, stackTag.format);
                     numCellsToAdd++;
                 }
                 else { // This is an array!
-                    bytesPerCell = Sim::cellSize(Pep::symbolFormat.value(stackSymbol));
+                    bytesPerCell = Sim::cellSize(stackTag.format);
                     for (int j = multiplier - 1; j >= 0; j--) {
                         offset += bytesPerCell;
-                        MemoryCellGraphicsItem *item = new MemoryCellGraphicsItem(Sim::stackPointer - offset + Sim::operandSpecifier,
-                                                                                  stackSymbol + QString("[%1]").arg(j),
-                                                                                  Pep::symbolFormat.value(stackSymbol),
-                                                                                  static_cast<int>(stackLocation.x()),
-                                                                                  static_cast<int>(stackLocation.y()));
-                        item->updateValue();
-                        stackLocation.setY(stackLocation.y() - MemoryCellGraphicsItem::boxHeight);
-                        isRuntimeStackItemAddedStack.push(false);
-                        runtimeStack.push(item);
-                        addressToStackItemMap.insert(Sim::stackPointer - offset + Sim::operandSpecifier, item);
+                        pushStackCell(Sim::stackPointer - offset + Sim::operandSpecifier,
+                                      stackSymbol + QString("[%1]").arg(j), stackTag.format);
                         numCellsToAdd++;
                     }
                 }
@@ -420,11 +386,9 @@ void MemoryTracePane::cacheStackChanges()
     }
 
     if (frameSizeToAdd != 0) {
+        // The frame is tied to the top cell of the stack, useful for determining when the
+        // frame should dissapear. IE: The top byte of the frame gets removed, so does the frame
         addStackFrame(frameSizeToAdd);
-        // This map is used to correlate the top of the stack frame with the frame itself,
-        // useful for determining when the frame should dissapear.
-        // IE: The top byte of the frame gets removed, so does the frame
-        stackHeightToStackFrameMap.insert(runtimeStack.size() - 1, graphicItemsInStackFrame.top());
     }
 }
 
@@ -437,15 +401,16 @@ void MemoryTracePane::cacheHeapChanges()
         ui->warningLabel->clear();
     }
 
-    if (Pep::decodeMnemonic[Sim::instructionSpecifier] == Enu::CALL && Pep::symbolTable.value("new") == Sim::operandSpecifier) {
+    if (Pep::decodeMnemonic[Sim::instructionSpecifier] == Enu::CALL && newAddress == Sim::operandSpecifier) {
         newestHeapItemsList.clear();
         int numCellsToAdd = 0;
         int offset = 0;
         int multiplier;
         QString heapSymbol;
+        int heapId;
         int heapPointer;
-        if (Pep::symbolTable.contains("hpPtr")) {
-            heapPointer = Pep::symbolTable.value("hpPtr");
+        if (heapPointerAddress >= 0) {
+            heapPointer = heapPointerAddress;
         }
         else {
             // We have no idea where the heap pointer is. Error!
@@ -457,11 +422,12 @@ void MemoryTracePane::cacheHeapChanges()
         // We'll start by adding up the number of bytes...
         for (int i = 0; i < lookAheadSymbolList.size(); i++) {
             heapSymbol = lookAheadSymbolList.at(i);
-            if (Pep::equateSymbols.contains(heapSymbol) || Pep::blockSymbols.contains(heapSymbol)) {
+            heapId = Pep::symbolId(heapSymbol);
+            if (heapId >= 0 && (Pep::symbols.at(heapId).isEquateSymbol || Pep::symbols.at(heapId).isBlockSymbol)) {
                 // listNumBytes += number of bytes for that tag * the multiplier (IE, 2d4a is a 4 cell
                 // array of 2 byte decimals, where 2 is the multiplier and 4 is the number of cells.
                 // Note: the multiplier should always be 1 for new'd cells, but that's checked below, where we'll give a more specific error.
-                listNumBytes += Asm::tagNumBytes(Pep::symbolFormat.value(heapSymbol)) * Pep::symbolFormatMultiplier.value(heapSymbol);
+                listNumBytes += Asm::tagNumBytes(Pep::symbols.at(heapId).format) * Pep::symbols.at(heapId).formatMultiplier;
             }
         }
         if (listNumBytes != Sim::accumulator) {
@@ -470,8 +436,9 @@ void MemoryTracePane::cacheHeapChanges()
         }
         for (int i = 0; i < lookAheadSymbolList.size(); i++) {
             heapSymbol = lookAheadSymbolList.at(i);
-            if (Pep::equateSymbols.contains(heapSymbol) || Pep::blockSymbols.contains(heapSymbol)) {
-                multiplier = Pep::symbolFormatMultiplier.value(heapSymbol);
+            heapId = Pep::symbolId(heapSymbol);
+            if (heapId >= 0 && (Pep::symbols.at(heapId).isEquateSymbol || Pep::symbols.at(heapId).isBlockSymbol)) {
+                multiplier = Pep::symbols.at(heapId).formatMultiplier;
             }
             else {
                 ui->warningLabel->setText("Warning: Symbol \"" + heapSymbol + "\" not found in .equates, unknown size.");
@@ -482,15 +449,15 @@ void MemoryTracePane::cacheHeapChanges()
                 moveHeapUpOneCell();
                 MemoryCellGraphicsItem *item = new MemoryCellGraphicsItem(Sim::readWord(heapPointer) + offset,
                                                                           heapSymbol,
-                                                                          Pep::symbolFormat.value(heapSymbol),
+                                                                          Pep::symbols.at(heapId).format,
                                                                           static_cast<int>(heapLocation.x()),
                                                                           static_cast<int>(heapLocation.y()));
                 item->updateValue();
                 isHeapItemAddedStack.push(false);
                 heap.push(item);
-                addressToHeapItemMap.insert(Sim::readWord(heapPointer) + offset, item);
+                indexCell(EHeapRegion, item);
                 newestHeapItemsList.append(item);
-                offset += Sim::cellSize(Pep::symbolFormat.value(heapSymbol));
+                offset += Sim::cellSize(Pep::symbols.at(heapId).format);
                 numCellsToAdd++;
             }
         }
@@ -532,16 +499,13 @@ void MemoryTracePane::setFocus()
 
 void MemoryTracePane::addStackFrame(int numCells)
 {
-    QPen pen(Qt::black);
-    pen.setWidth(4);
-    QGraphicsRectItem *item = new QGraphicsRectItem(stackLocation.x() - 2, stackLocation.y() + MemoryCellGraphicsItem::boxHeight, 
-                      static_cast<qreal>(MemoryCellGraphicsItem::boxWidth + 4),
-                      static_cast<qreal>(MemoryCellGraphicsItem::boxHeight * numCells), 0);
-    item->setPen(pen);
-    graphicItemsInStackFrame.push(item);
-    isStackFrameAddedStack.push(false);
-    item->setZValue(1.0); // This moves the stack frame to the front
-    numCellsInStackFrame.push(numCells);
+    StackFrame frame;
+    frame.topCell = runtimeStack.size() - 1;
+    frame.rect = QRectF(stackLocation.x() - 2, stackLocation.y() + MemoryCellGraphicsItem::boxHeight,
+                        static_cast<qreal>(MemoryCellGraphicsItem::boxWidth + 4),
+                        static_cast<qreal>(MemoryCellGraphicsItem::boxHeight * numCells));
+    frame.item = NULL;
+    stackFrames.append(frame);
 }
 
 void MemoryTracePane::addHeapFrame(int numCells)
@@ -571,26 +535,203 @@ void MemoryTracePane::moveHeapUpOneCell()
 void MemoryTracePane::popBytes(int bytesToPop)
 {
     while (bytesToPop > 0 && !runtimeStack.isEmpty()) {
-        if (stackHeightToStackFrameMap.contains(runtimeStack.size() - 1)) {
-            if (stackHeightToStackFrameMap.value(runtimeStack.size() - 1)->scene() == scene) {
-                scene->removeItem(stackHeightToStackFrameMap.value(runtimeStack.size() - 1));
+        int top = runtimeStack.size() - 1;
+        while (!stackFrames.isEmpty() && stackFrames.last().topCell >= top) {
+            releaseStackFrame(stackFrames.size() - 1);
+            stackFrames.remove(stackFrames.size() - 1);
+        }
+        releaseStackCell(top);
+        bytesToPop -= Sim::cellSize(runtimeStack.last().format);
+        runtimeStack.remove(top);
+        stackLocation.setY(stackLocation.y() + MemoryCellGraphicsItem::boxHeight);
+    }
+    lastMaterializedCell = qMin(lastMaterializedCell, runtimeStack.size() - 1);
+    lastMaterializedFrame = qMin(lastMaterializedFrame, stackFrames.size() - 1);
+}
+
+void MemoryTracePane::pushStackCell(int address, const QString &symbol, Enu::ESymbolFormat format)
+{
+    StackCell cell;
+    cell.address = address;
+    cell.symbol = symbol;
+    cell.format = format;
+    cell.x = static_cast<int>(stackLocation.x());
+    cell.y = static_cast<int>(stackLocation.y());
+    cell.item = NULL;
+    runtimeStack.append(cell);
+    stackLocation.setY(stackLocation.y() - MemoryCellGraphicsItem::boxHeight);
+}
+
+void MemoryTracePane::releaseStackCell(int index)
+{
+    MemoryCellGraphicsItem *item = runtimeStack.at(index).item;
+    if (item == NULL) {
+        return;
+    }
+    if (item->scene() == scene) {
+        scene->removeItem(item);
+    }
+    highlightedCells.removeAll(item);
+    unindexCell(EStackRegion, item);
+    cellPool.push(item);
+    runtimeStack[index].item = NULL;
+}
+
+void MemoryTracePane::releaseStackFrame(int index)
+{
+    QGraphicsRectItem *item = stackFrames.at(index).item;
+    if (item == NULL) {
+        return;
+    }
+    if (item->scene() == scene) {
+        scene->removeItem(item);
+    }
+    framePool.push(item);
+    stackFrames[index].item = NULL;
+}
+
+void MemoryTracePane::materializeStack()
+{
+    int firstCell = 0;
+    int lastCell = -1;
+    if (!runtimeStack.isEmpty()) {
+        QRectF visible = ui->graphicsView->mapToScene(ui->graphicsView->viewport()->rect()).boundingRect();
+        qreal top = visible.top() - visible.height();
+        qreal bottom = visible.bottom() + visible.height();
+        // Cell i is drawn at baseY - i * boxHeight.
+        int baseY = runtimeStack.first().y;
+        int h = MemoryCellGraphicsItem::boxHeight;
+        firstCell = qMax(0, static_cast<int>((baseY - bottom) / h));
+        lastCell = qMin(runtimeStack.size() - 1, static_cast<int>((baseY + h - top) / h));
+    }
+
+    for (int i = firstMaterializedCell; i <= lastMaterializedCell; i++) {
+        if (i < firstCell || i > lastCell) {
+            releaseStackCell(i);
+        }
+    }
+    for (int i = firstCell; i <= lastCell; i++) {
+        StackCell &cell = runtimeStack[i];
+        if (cell.item != NULL) {
+            continue;
+        }
+        if (cellPool.isEmpty()) {
+            cell.item = new MemoryCellGraphicsItem(cell.address, cell.symbol, cell.format, cell.x, cell.y);
+        }
+        else {
+            cell.item = cellPool.pop();
+            cell.item->reset(cell.address, cell.symbol, cell.format, cell.x, cell.y);
+        }
+        cell.item->updateValue();
+        indexCell(EStackRegion, cell.item);
+        scene->addItem(cell.item);
+    }
+    firstMaterializedCell = firstCell;
+    lastMaterializedCell = lastCell;
+
+    // Frames are ordered by their top cell, so the ones that overlap the cells are consecutive.
+    int firstFrame = 0;
+    int lastFrame = -1;
+    if (lastCell >= firstCell) {
+        int low = 0;
+        int high = stackFrames.size();
+        while (low < high) {
+            int mid = (low + high) / 2;
+            if (stackFrames.at(mid).topCell < firstCell) {
+                low = mid + 1;
+            }
+            else {
+                high = mid;
             }
-            delete stackHeightToStackFrameMap.value(runtimeStack.size() - 1);
-            graphicItemsInStackFrame.pop();
-            stackHeightToStackFrameMap.remove(runtimeStack.size() - 1);
-            isStackFrameAddedStack.pop();
-            numCellsInStackFrame.pop();
         }
-        
-        if (runtimeStack.top()->scene() == scene) {
-            scene->removeItem(runtimeStack.top());
+        firstFrame = low;
+        lastFrame = low - 1;
+        int h = MemoryCellGraphicsItem::boxHeight;
+        while (lastFrame + 1 < stackFrames.size()) {
+            const StackFrame &frame = stackFrames.at(lastFrame + 1);
+            int frameFirstCell = frame.topCell - static_cast<int>(frame.rect.height()) / h + 1;
+            if (frameFirstCell > lastCell) {
+                break;
+            }
+            lastFrame++;
         }
-        addressToStackItemMap.remove(runtimeStack.top()->getAddress());
-        bytesToPop -= runtimeStack.top()->getNumBytes();
-        delete runtimeStack.top();
-        runtimeStack.pop();
-        isRuntimeStackItemAddedStack.pop();
-        stackLocation.setY(stackLocation.y() + MemoryCellGraphicsItem::boxHeight);
+    }
+    for (int i = firstMaterializedFrame; i <= lastMaterializedFrame; i++) {
+        if (i < firstFrame || i > lastFrame) {
+            releaseStackFrame(i);
+        }
+    }
+    for (int i = firstFrame; i <= lastFrame; i++) {
+        StackFrame &frame = stackFrames[i];
+        if (frame.item != NULL) {
+            continue;
+        }
+        if (framePool.isEmpty()) {
+            QPen pen(Qt::black);
+            pen.setWidth(4);
+            frame.item = new QGraphicsRectItem(frame.rect, 0);
+            frame.item->setPen(pen);
+            frame.item->setZValue(1.0); // This moves the stack frame to the front
+        }
+        else {
+            frame.item = framePool.pop();
+            frame.item->setRect(frame.rect);
+        }
+        scene->addItem(frame.item);
+    }
+    firstMaterializedFrame = firstFrame;
+    lastMaterializedFrame = lastFrame;
+}
+
+void MemoryTracePane::indexCell(ERegion region, MemoryCellGraphicsItem *item)
+{
+    for (int i = 0; i < item->getNumBytes(); i++) {
+        int address = item->getAddress() + i;
+        if (address >= 0 && address < 65536) {
+            addressToItem[region][address] = item;
+        }
+    }
+}
+
+void MemoryTracePane::unindexCell(ERegion region, MemoryCellGraphicsItem *item)
+{
+    for (int i = 0; i < item->getNumBytes(); i++) {
+        int address = item->getAddress() + i;
+        if (address >= 0 && address < 65536 && addressToItem[region].at(address) == item) {
+            addressToItem[region][address] = NULL;
+        }
+    }
+}
+
+void MemoryTracePane::highlightCell(MemoryCellGraphicsItem *item, QColor background, QColor text)
+{
+    item->boxBgColor = background;
+    item->boxTextColor = text;
+    item->update();
+    highlightedCells.append(item);
+}
+
+void MemoryTracePane::updateSceneRect()
+{
+    QRectF rect = baseSceneRect;
+    if (!runtimeStack.isEmpty()) {
+        rect |= MemoryCellGraphicsItem::boundingRectAt(runtimeStack.first().x, runtimeStack.first().y);
+        rect |= MemoryCellGraphicsItem::boundingRectAt(runtimeStack.last().x, runtimeStack.last().y);
+    }
+    if (!stackFrames.isEmpty()) {
+        rect |= stackFrames.last().rect.adjusted(-2, -2, 2, 2); // Half the pen width
+    }
+    // Each new heap item pushes the older ones up, so the oldest is on top.
+    if (!heap.isEmpty()) {
+        rect |= heap.first()->sceneBoundingRect();
+        rect |= heap.top()->sceneBoundingRect();
+    }
+    if (!heapFrameItemStack.isEmpty()) {
+        rect |= heapFrameItemStack.first()->sceneBoundingRect();
+        rect |= heapFrameItemStack.top()->sceneBoundingRect();
+    }
+    if (rect != scene->sceneRect()) {
+        scene->setSceneRect(rect);
     }
 }
 
@@ -604,6 +745,7 @@ void MemoryTracePane::zoomFactorChanged(int factor)
     QMatrix matrix;
     matrix.scale(factor * .01, factor * .01);
     ui->graphicsView->setMatrix(matrix);
+    materializeStack();
 }
 
 void MemoryTracePane::mouseDoubleClickEvent(QMouseEvent *)
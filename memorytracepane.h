@@ -26,6 +26,7 @@
 #include <QGraphicsScene>
 #include <QStack>
 #include <QSet>
+#include <QVector>
 #include "memorycellgraphicsitem.h"
 #include "enu.h"
 #include "stackframefsm.h"
@@ -74,12 +75,19 @@ private:
     QGraphicsScene *scene;
     QStack<MemoryCellGraphicsItem *> globalVars;
     // Stack of the global variables
-    QStack<MemoryCellGraphicsItem *> runtimeStack;    
-    // Stack of the stack items
+    struct StackCell
+    {
+        int address;
+        QString symbol;
+        Enu::ESymbolFormat format;
+        int x;
+        int y;
+        MemoryCellGraphicsItem *item; // NULL unless the cell is near the viewport
+    };
+    QVector<StackCell> runtimeStack;
+    // Cells of the runtime stack, bottom first
     QStack<MemoryCellGraphicsItem *> heap;
     // Stack of heap items
-    QStack<bool> isRuntimeStackItemAddedStack;
-    // Used to keep track if the item has been added to the scene yet for the runtime stack
     QStack<bool> isHeapItemAddedStack;
     // Used to keep track if the item has been added to the scene yet for the heap
     QStringList lookAheadSymbolList;
@@ -87,13 +95,23 @@ private:
     // It must be a look-ahead list because of branching and the inability to look behind
 
     // Stack frame
-    QMap<int, QGraphicsRectItem *> stackHeightToStackFrameMap;
-    QStack<int> numCellsInStackFrame;
-    // This is a stack of ints that each represent how many cells each stack frame encompass
-    QStack<bool> isStackFrameAddedStack;
-    // Stack used to determine if a stack frame has been added to the scene yet
-    QStack<QGraphicsRectItem *> graphicItemsInStackFrame;
-    // Stack of *items used to access the stack frames
+    struct StackFrame
+    {
+        int topCell; // Index in runtimeStack of the top cell of the frame
+        QRectF rect;
+        QGraphicsRectItem *item; // NULL unless the frame is near the viewport
+    };
+    QVector<StackFrame> stackFrames;
+    // Frames of the runtime stack, bottom first. A frame is removed with its top cell.
+
+    // Only the stack cells and frames near the viewport have graphics items, taken from these
+    // pools and returned to them when they scroll away or are popped.
+    int firstMaterializedCell;
+    int lastMaterializedCell;
+    int firstMaterializedFrame;
+    int lastMaterializedFrame;
+    QStack<MemoryCellGraphicsItem *> cellPool;
+    QStack<QGraphicsRectItem *> framePool;
     QStack<bool> isHeapFrameAddedStack;
     // Stack used to determine if a heap frame has been added to the scene yet
     QStack<QGraphicsRectItem *> heapFrameItemStack;
@@ -106,18 +124,22 @@ private:
     QPointF heapLocation;
     // This is the location where the next heap item will be added
 
-    QMap<int, MemoryCellGraphicsItem *> addressToGlobalItemMap;
-    // This map is used to identify if an address is in the globals
-    QMap<int, MemoryCellGraphicsItem *> addressToStackItemMap;
-    // This map is used to identify if an address is part of the stack
-    QMap<int, MemoryCellGraphicsItem *> addressToHeapItemMap;
-    // Used to identify if an address is part of the heap
+    enum ERegion { EGlobalRegion, EStackRegion, EHeapRegion, ERegionCount };
+    QVector<MemoryCellGraphicsItem *> addressToItem[ERegionCount];
+    // Flat index from each byte of memory to the cell of each region that holds it, or NULL
+    QList<MemoryCellGraphicsItem *> highlightedCells;
+    // Cells colored by the last update, to be colored normally by the next one
+    QRectF baseSceneRect;
+    // Bounding rect of the globals and the stack base, which do not change after setMemoryTrace
     QSet<int> modifiedBytes;
     // This set is used to cache modified bytes since the last update
     QList<int> bytesWrittenLastStep;
     // This list is used to keep track of the bytes changed last step for highlighting purposes
     bool delayLastStepClear;
     // This is used to delay the clear of the bytesWrittenLastStep list for purposes of highlighting after a trap
+    int newAddress;
+    int heapPointerAddress;
+    // Values of the symbols new and hpPtr, looked up once by setMemoryTrace, or -1 if they are not defined
 
     QList<MemoryCellGraphicsItem *> newestHeapItemsList;
     // This is used to color the most recently new'd heap items light green
@@ -135,12 +157,36 @@ private:
     void popBytes(int bytesToPop);
     // This pops bytesToPop bytes off of the runtimeStack
 
+    void pushStackCell(int address, const QString &symbol, Enu::ESymbolFormat format);
+    // Post: A cell is pushed on runtimeStack at stackLocation, which moves up one cell.
+
+    void releaseStackCell(int index);
+    void releaseStackFrame(int index);
+    // Post: The graphics item of the cell or frame, if any, is removed from the scene and pooled.
+
+    void indexCell(ERegion region, MemoryCellGraphicsItem *item);
+    // Post: Each byte of item is mapped to item in the index of region.
+
+    void unindexCell(ERegion region, MemoryCellGraphicsItem *item);
+    // Post: The bytes of item no longer map to item in the index of region.
+
+    void highlightCell(MemoryCellGraphicsItem *item, QColor background, QColor text);
+    // Post: item is colored and scheduled for repainting, and is colored normally at the next update.
+
+    void updateSceneRect();
+    // Post: The scene rect bounds the items of the scene. Only the ends of the stack and the heap
+    // can move past baseSceneRect, so only they are measured.
+
     void mouseReleaseEvent(QMouseEvent *);
     void mouseDoubleClickEvent(QMouseEvent *);
 
 private slots:
     void zoomFactorChanged(int factor);
 
+    void materializeStack();
+    // Post: The stack cells and frames within a viewport height of the viewport have graphics
+    // items in the scene, and the others do not.
+
 signals:
     void labelDoubleClicked(Enu::EPane pane);
 
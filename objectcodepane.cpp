@@ -63,24 +63,35 @@ void ObjectCodePane::setObjectCodePaneText(QString string)
 bool ObjectCodePane::getObjectCode(QList<int> &objectCodeList)
 {
     QString objectString = ui->textEdit->toPlainText();
-    while (objectString.length() > 0) {
-        if (objectString.at(1) == QChar('z')) {
+    const QChar *text = objectString.constData();
+    const int length = objectString.length();
+    objectCodeList.reserve(length / 3);
+    // Each byte is two hex digits and one trailing separator
+    for (int i = 0; i + 1 < length; i += 3) {
+        if (text[i] == QChar('z') && text[i + 1] == QChar('z')) {
             return true;
         }
-        if (objectString.length() < 3) {
+        if (i + 2 >= length) {
             return false;
         }
-        QString s = objectString.left(2); // Get the two-char hex number
-        objectString.remove(0, 3); // Removes the number and trailing whitespace
-        bool ok;
-        objectCodeList.append(s.toInt(&ok, 16));
-        if (!ok) {
+        int high = Pep::hexDigitValue(text[i]);
+        int low = Pep::hexDigitValue(text[i + 1]);
+        if (high < 0 || low < 0) {
             return false;
         }
+        objectCodeList.append(high * 16 + low);
     }
     return false;
 }
 
+void ObjectCodePane::setCursorPosition(int offset)
+{
+    QTextCursor cursor = ui->textEdit->textCursor();
+    cursor.setPosition(qMin(offset, ui->textEdit->document()->characterCount() - 1));
+    ui->textEdit->setTextCursor(cursor);
+    ui->textEdit->setFocus();
+}
+
 void ObjectCodePane::ObjectCodePane::clearObjectCode()
 {
     ui->textEdit->clear();
@@ -48,6 +48,9 @@ public:
     // &objectCodeList contains the object code, one byte per integer.
     // Otherwise, false is returned.
 
+    void setCursorPosition(int offset);
+    // Post: The cursor is placed at character offset in the pane and the pane has focus.
+
     void clearObjectCode();
     // Post: Clears the source code pane
 
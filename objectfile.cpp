@@ -0,0 +1,365 @@
+// File: objectfile.cpp
+/*
+    Pep8-1 is a virtual machine for writing machine language and assembly
+    language programs.
+    
+    Copyright (C) 2009  J. Stanley Warford, Pepperdine University
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <QDataStream>
+#include <QFile>
+#include <QSet>
+#include "objectfile.h"
+#include "pep.h"
+
+static QByteArray encodeImage(const QList<int> &objectCode, int loadAddress)
+{
+    QByteArray bytes;
+    bytes.reserve(objectCode.size());
+    for (int i = 0; i < objectCode.size(); i++) {
+        bytes.append(static_cast<char>(objectCode[i]));
+    }
+    QByteArray image;
+    QDataStream imageStream(&image, QIODevice::WriteOnly);
+    imageStream.setVersion(QDataStream::Qt_4_5);
+    imageStream << quint16(loadAddress) << bytes;
+    return image;
+}
+
+static bool decodeImage(const QByteArray &image, QList<int> &objectCode, int &loadAddress)
+{
+    QDataStream imageStream(image);
+    imageStream.setVersion(QDataStream::Qt_4_5);
+    quint16 imageAddress;
+    QByteArray bytes;
+    imageStream >> imageAddress >> bytes;
+    objectCode.clear();
+    objectCode.reserve(bytes.size());
+    for (int i = 0; i < bytes.size(); i++) {
+        objectCode.append(static_cast<unsigned char>(bytes.at(i)));
+    }
+    loadAddress = imageAddress;
+    return imageStream.status() == QDataStream::Ok;
+}
+
+static QByteArray encodeSymbols(const QVector<Pep::Symbol> &symbols)
+{
+    QByteArray section;
+    QDataStream symbolStream(&section, QIODevice::WriteOnly);
+    symbolStream.setVersion(QDataStream::Qt_4_5);
+    symbolStream << qint32(symbols.size());
+    for (int i = 0; i < symbols.size(); i++) {
+        const Pep::Symbol &symbol = symbols.at(i);
+        symbolStream << symbol.name << qint32(symbol.kind) << qint32(symbol.value) << symbol.adjustForBurn
+                << qint32(symbol.format) << qint32(symbol.formatMultiplier)
+                << symbol.isBlockSymbol << symbol.isEquateSymbol;
+    }
+    return section;
+}
+
+static bool decodeSymbols(const QByteArray &section, QVector<Pep::Symbol> &symbols)
+{
+    QDataStream symbolStream(section);
+    symbolStream.setVersion(QDataStream::Qt_4_5);
+    qint32 numSymbols;
+    symbolStream >> numSymbols;
+    for (int i = 0; i < numSymbols && symbolStream.status() == QDataStream::Ok; i++) {
+        Pep::Symbol symbol;
+        qint32 kind, value, format, formatMultiplier;
+        symbolStream >> symbol.name >> kind >> value >> symbol.adjustForBurn
+                >> format >> formatMultiplier >> symbol.isBlockSymbol >> symbol.isEquateSymbol;
+        symbol.kind = static_cast<Enu::ESymbolKind>(kind);
+        symbol.value = value;
+        symbol.format = static_cast<Enu::ESymbolFormat>(format);
+        symbol.formatMultiplier = formatMultiplier;
+        symbol.definitionLineNum = -1; // The cross-reference index is not saved.
+        symbols.append(symbol);
+    }
+    return symbolStream.status() == QDataStream::Ok;
+}
+
+static bool writeSections(const QString &fileName, const QList<quint32> &tags, const QList<QByteArray> &sections,
+                          QString &errorString)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        errorString = file.errorString();
+        return false;
+    }
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_4_5);
+    out << ObjectFile::magic << ObjectFile::version;
+    for (int i = 0; i < tags.size(); i++) {
+        out << tags.at(i) << sections.at(i);
+    }
+    if (out.status() != QDataStream::Ok) {
+        errorString = file.errorString();
+        return false;
+    }
+    return true;
+}
+
+static bool readSections(const QString &fileName, QMap<quint32, QByteArray> &sections, QString &errorString)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        errorString = file.errorString();
+        return false;
+    }
+    // Map the file rather than read it, so the sections are decoded straight from the page cache.
+    QByteArray contents;
+    uchar *mapped = file.map(0, file.size());
+    if (mapped != 0) {
+        contents = QByteArray::fromRawData(reinterpret_cast<const char *>(mapped), static_cast<int>(file.size()));
+    }
+    else {
+        contents = file.readAll();
+    }
+    QDataStream in(contents);
+    in.setVersion(QDataStream::Qt_4_5);
+
+    quint32 fileMagic;
+    quint16 fileVersion;
+    in >> fileMagic >> fileVersion;
+    if (fileMagic != ObjectFile::magic || fileVersion > ObjectFile::version) {
+        errorString = "Not a Pep/8 binary object file, or from a newer version of Pep/8.";
+        return false;
+    }
+    while (!in.atEnd()) {
+        quint32 tag;
+        QByteArray section;
+        in >> tag >> section;
+        if (in.status() != QDataStream::Ok) {
+            errorString = "The binary object file is truncated.";
+            return false;
+        }
+        sections.insert(tag, section);
+    }
+    return true;
+}
+
+static bool symbolIdsAreValid(const QVector<Pep::Symbol> &symbols, const QList<int> &ids)
+// Post: Returns true if every id in ids indexes symbols.
+{
+    for (int i = 0; i < ids.size(); i++) {
+        if (ids.at(i) < 0 || ids.at(i) >= symbols.size()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool listingIsValid(const QStringList &listingList, const QList<bool> &checkBoxes,
+                           const QMap<int, int> &addressMap)
+// Post: Returns true if there is a check box flag for every listing row and every address
+// maps to a listing row.
+{
+    if (checkBoxes.size() != listingList.size()) {
+        return false;
+    }
+    foreach (int row, addressMap) {
+        if (row < 0 || row >= listingList.size()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool traceTagsAreValid(const QVector<Pep::Symbol> &symbols, const QList<int> &blockSymbols,
+                              const QList<int> &equateSymbols, const QMap<QString, QStringList> &globalStructSymbols,
+                              const QMap<int, QStringList> &symbolTraceList)
+// Post: Returns true if every symbol the trace tags refer to, by id or by name, is in symbols.
+{
+    if (!symbolIdsAreValid(symbols, blockSymbols) || !symbolIdsAreValid(symbols, equateSymbols)) {
+        return false;
+    }
+    QSet<QString> names;
+    for (int i = 0; i < symbols.size(); i++) {
+        names.insert(symbols.at(i).name);
+    }
+    QStringList referencedNames = globalStructSymbols.keys();
+    foreach (const QStringList &fields, globalStructSymbols) {
+        referencedNames << fields;
+    }
+    foreach (const QStringList &tags, symbolTraceList) {
+        referencedNames << tags;
+    }
+    for (int i = 0; i < referencedNames.size(); i++) {
+        if (!names.contains(referencedNames.at(i))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ObjectFile::isObjectFileName(const QString &fileName)
+{
+    return fileName.endsWith(".pepobj", Qt::CaseInsensitive);
+}
+
+bool ObjectFile::isModuleFileName(const QString &fileName)
+{
+    return fileName.endsWith(".pepmod", Qt::CaseInsensitive);
+}
+
+bool ObjectFile::write(const QString &fileName, const QList<int> &objectCode, int loadAddress,
+                       const QStringList &assemblerListingList, const QList<bool> &hasCheckBox,
+                       const QMap<int, int> &memAddrssToAssemblerListing, bool withTraceTags, QString &errorString)
+{
+    QList<quint32> tags;
+    QList<QByteArray> sections;
+    tags << tagImage << tagSymbols << tagListing;
+    sections << encodeImage(objectCode, loadAddress) << encodeSymbols(Pep::symbols);
+
+    QByteArray listing;
+    QDataStream listingStream(&listing, QIODevice::WriteOnly);
+    listingStream.setVersion(QDataStream::Qt_4_5);
+    listingStream << assemblerListingList << hasCheckBox << memAddrssToAssemblerListing;
+    sections << listing;
+
+    if (withTraceTags) {
+        QByteArray traceTags;
+        QDataStream traceTagStream(&traceTags, QIODevice::WriteOnly);
+        traceTagStream.setVersion(QDataStream::Qt_4_5);
+        traceTagStream << Pep::traceTagWarning << Pep::blockSymbols << Pep::equateSymbols
+                << Pep::globalStructSymbols << Pep::symbolTraceList;
+        tags << tagTraceTags;
+        sections << traceTags;
+    }
+    return writeSections(fileName, tags, sections, errorString);
+}
+
+bool ObjectFile::writeImage(const QString &fileName, const QList<int> &objectCode, int loadAddress,
+                            QString &errorString)
+{
+    QList<quint32> tags;
+    QList<QByteArray> sections;
+    tags << tagImage;
+    sections << encodeImage(objectCode, loadAddress);
+    return writeSections(fileName, tags, sections, errorString);
+}
+
+bool ObjectFile::read(const QString &fileName, QList<int> &objectCode, int &loadAddress,
+                      QStringList &assemblerListingList, QList<bool> &hasCheckBox,
+                      QMap<int, int> &memAddrssToAssemblerListing, QString &errorString,
+                      int requiredLoadAddress)
+{
+    QMap<quint32, QByteArray> sections;
+    if (!readSections(fileName, sections, errorString)) {
+        return false;
+    }
+
+    // Decode everything before touching the Pep tables.
+    QList<int> image;
+    int imageAddress = 0;
+    QVector<Pep::Symbol> symbols;
+    QStringList listingList;
+    QList<bool> checkBoxes;
+    QMap<int, int> addressMap;
+    bool traceTagWarning = false;
+    QList<int> blockSymbols;
+    QList<int> equateSymbols;
+    QMap<QString, QStringList> globalStructSymbols;
+    QMap<int, QStringList> symbolTraceList;
+    bool ok = decodeImage(sections.value(tagImage), image, imageAddress);
+    if (ok && sections.contains(tagSymbols)) {
+        ok = decodeSymbols(sections.value(tagSymbols), symbols);
+    }
+    if (ok && sections.contains(tagListing)) {
+        QDataStream listingStream(sections.value(tagListing));
+        listingStream.setVersion(QDataStream::Qt_4_5);
+        listingStream >> listingList >> checkBoxes >> addressMap;
+        ok = listingStream.status() == QDataStream::Ok && listingIsValid(listingList, checkBoxes, addressMap);
+    }
+    if (ok && sections.contains(tagTraceTags)) {
+        QDataStream traceTagStream(sections.value(tagTraceTags));
+        traceTagStream.setVersion(QDataStream::Qt_4_5);
+        traceTagStream >> traceTagWarning >> blockSymbols >> equateSymbols >> globalStructSymbols >> symbolTraceList;
+        ok = traceTagStream.status() == QDataStream::Ok
+             && traceTagsAreValid(symbols, blockSymbols, equateSymbols, globalStructSymbols, symbolTraceList);
+    }
+    if (!ok) {
+        errorString = "The binary object file is corrupt.";
+        return false;
+    }
+    if (requiredLoadAddress >= 0 && imageAddress != requiredLoadAddress) {
+        errorString = QString("The object code loads at 0x%1 instead of 0x%2")
+                      .arg(imageAddress, 4, 16, QLatin1Char('0'))
+                      .arg(requiredLoadAddress, 4, 16, QLatin1Char('0'));
+        return false;
+    }
+
+    objectCode = image;
+    loadAddress = imageAddress;
+    assemblerListingList = listingList;
+    hasCheckBox = checkBoxes;
+    memAddrssToAssemblerListing = addressMap;
+    Pep::clearSymbolTable();
+    Pep::symbols = symbols;
+    for (int i = 0; i < symbols.size(); i++) {
+        Pep::symbolIds.insert(symbols.at(i).name, i);
+    }
+    if (sections.contains(tagTraceTags)) {
+        Pep::traceTagWarning = traceTagWarning;
+        Pep::blockSymbols = blockSymbols;
+        Pep::equateSymbols = equateSymbols;
+        Pep::globalStructSymbols = globalStructSymbols;
+        Pep::symbolTraceList = symbolTraceList;
+    }
+    return true;
+}
+
+bool ObjectFile::writeModule(const QString &fileName, const QList<int> &objectCode,
+                             const QList<int> &relocationOffsets, const QStringList &relocationSymbols,
+                             QString &errorString)
+{
+    QByteArray relocations;
+    QDataStream relocationStream(&relocations, QIODevice::WriteOnly);
+    relocationStream.setVersion(QDataStream::Qt_4_5);
+    relocationStream << relocationOffsets << relocationSymbols;
+
+    QList<quint32> tags;
+    QList<QByteArray> sections;
+    tags << tagImage << tagSymbols << tagRelocations;
+    sections << encodeImage(objectCode, 0) << encodeSymbols(Pep::symbols) << relocations;
+    return writeSections(fileName, tags, sections, errorString);
+}
+
+bool ObjectFile::readModule(const QString &fileName, QList<int> &objectCode, QVector<Pep::Symbol> &symbols,
+                            QList<int> &relocationOffsets, QStringList &relocationSymbols, QString &errorString)
+{
+    QMap<quint32, QByteArray> sections;
+    if (!readSections(fileName, sections, errorString)) {
+        return false;
+    }
+    if (!sections.contains(tagRelocations)) {
+        errorString = "The file is not a relocatable module.";
+        return false;
+    }
+    int loadAddress;
+    symbols.clear();
+    QDataStream relocationStream(sections.value(tagRelocations));
+    relocationStream.setVersion(QDataStream::Qt_4_5);
+    relocationStream >> relocationOffsets >> relocationSymbols;
+    if (relocationStream.status() != QDataStream::Ok
+        || relocationOffsets.size() != relocationSymbols.size()
+        || !decodeImage(sections.value(tagImage), objectCode, loadAddress)
+        || !decodeSymbols(sections.value(tagSymbols), symbols)) {
+        errorString = "The module file is corrupt.";
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,99 @@
+// File: objectfile.h
+/*
+    Pep8-1 is a virtual machine for writing machine language and assembly
+    language programs.
+    
+    Copyright (C) 2009  J. Stanley Warford, Pepperdine University
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OBJECTFILE_H
+#define OBJECTFILE_H
+
+#include <QByteArray>
+#include <QList>
+#include <QMap>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include "pep.h"
+
+// Binary object files (.pepobj) hold everything needed to debug a program without its source:
+// the memory image and load address, the symbol table, the assembler listing with its
+// address-to-row map, and optionally the trace tag tables. The file is a header followed by tagged
+// sections, each a QDataStream-encoded byte array, so readers skip sections they do not know.
+// Relocatable modules (.pepmod) use the same container with the image assembled at address 0,
+// the module's symbol table, and a relocation section listing where each symbol value is used.
+class ObjectFile
+{
+public:
+    static const quint32 magic = 0x5045504f; // "PEPO"
+    static const quint16 version = 1;
+
+    // Section tags
+    static const quint32 tagImage = 0x494d4147; // "IMAG"
+    static const quint32 tagSymbols = 0x53594d42; // "SYMB"
+    static const quint32 tagListing = 0x4c495354; // "LIST"
+    static const quint32 tagTraceTags = 0x54524143; // "TRAC"
+    static const quint32 tagRelocations = 0x52454c4f; // "RELO"
+
+    static bool isObjectFileName(const QString &fileName);
+    // Post: Returns true if fileName has the binary object file extension .pepobj.
+
+    static bool isModuleFileName(const QString &fileName);
+    // Post: Returns true if fileName has the relocatable module extension .pepmod.
+
+    static bool write(const QString &fileName, const QList<int> &objectCode, int loadAddress,
+                      const QStringList &assemblerListingList, const QList<bool> &hasCheckBox,
+                      const QMap<int, int> &memAddrssToAssemblerListing, bool withTraceTags, QString &errorString);
+    // Pre: objectCode is the object code of the program last assembled, which loads at loadAddress.
+    // Pre: assemblerListingList, hasCheckBox and memAddrssToAssemblerListing are from the same
+    // assembly, and so is the Pep symbol table.
+    // Post: The object code, the listing, the address map, the symbol table and, if withTraceTags,
+    // the trace tag tables are written to fileName and true is returned.
+    // Post: If the file cannot be written, false is returned and errorString is set.
+
+    static bool writeImage(const QString &fileName, const QList<int> &objectCode, int loadAddress,
+                           QString &errorString);
+    // Post: Only the object code and its load address are written to fileName, with no symbols
+    // or listing, and true is returned.
+    // Post: If the file cannot be written, false is returned and errorString is set.
+
+    static bool read(const QString &fileName, QList<int> &objectCode, int &loadAddress,
+                     QStringList &assemblerListingList, QList<bool> &hasCheckBox,
+                     QMap<int, int> &memAddrssToAssemblerListing, QString &errorString,
+                     int requiredLoadAddress = -1);
+    // Post: If fileName is a valid binary object file, the object code, its load address, the
+    // listing and the address map, empty if the file has none, are returned, the symbol table and any trace tag tables in
+    // the file are restored, and true is returned.
+    // Post: Otherwise, or if requiredLoadAddress is not -1 and the object code loads at another
+    // address, false is returned, errorString is set, and the Pep tables are unchanged.
+
+    static bool writeModule(const QString &fileName, const QList<int> &objectCode,
+                            const QList<int> &relocationOffsets, const QStringList &relocationSymbols,
+                            QString &errorString);
+    // Pre: objectCode is a module assembled at address 0 and the Pep symbol table is from its assembly.
+    // Pre: The symbol relocationSymbols[i] is used by the word at relocationOffsets[i] in objectCode.
+    // Post: The module is written to fileName and true is returned.
+    // Post: If the file cannot be written, false is returned and errorString is set.
+
+    static bool readModule(const QString &fileName, QList<int> &objectCode, QVector<Pep::Symbol> &symbols,
+                           QList<int> &relocationOffsets, QStringList &relocationSymbols, QString &errorString);
+    // Post: If fileName is a valid module, its object code, symbol table and relocations are
+    // returned and true is returned. The Pep tables are not used.
+    // Post: Otherwise false is returned and errorString is set.
+};
+
+#endif // OBJECTFILE_H
@@ -0,0 +1,370 @@
+// File: peephole.cpp
+/*
+    Pep8-1 is a virtual machine for writing machine language and assembly
+    language programs.
+    
+    Copyright (C) 2009  J. Stanley Warford, Pepperdine University
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <QHash>
+#include <QSet>
+#include "peephole.h"
+#include "code.h"
+#include "flowgraph.h"
+#include "argument.h"
+#include "pep.h"
+#include "sim.h"
+
+using namespace Enu;
+
+// Status bits in the order of the NZVC flags
+static const int flagN = 8;
+static const int flagZ = 4;
+static const int flagV = 2;
+static const int flagC = 1;
+static const int flagsNZVC = flagN | flagZ | flagV | flagC;
+
+// Rewrites collected during one pass
+struct Rewrites
+{
+    QSet<int> removedLines;
+    QHash<int, QString> replacedLines;
+    QSet<Code *> touched;
+};
+
+bool Peephole::assemble(const QStringList &sourceCodeList, QVector<Asm::ParsedLine> &cache, QList<Code *> &codeList,
+                        QList<int> &objectCode, QString &errorString)
+{
+    int lineNum;
+    if (!Asm::assembleProgram(sourceCodeList, cache, codeList, Enu::EProgram, objectCode, lineNum, errorString)) {
+        errorString = QString("Line %1: %2").arg(lineNum + 1).arg(errorString);
+        return false;
+    }
+    return true;
+}
+
+int Peephole::flagsRead(EMnemonic mnemonic)
+{
+    switch (mnemonic) {
+    case BRLE: case BRGT: return flagN | flagZ;
+    case BRLT: case BRGE: return flagN;
+    case BREQ: case BRNE: return flagZ;
+    case BRV: return flagV;
+    case BRC: case ROLA: case ROLX: case RORA: case RORX: return flagC;
+    case MOVFLGA: return flagsNZVC;
+    default:
+        // A trap saves the flags and RETTR restores them.
+        return Pep::isTrapMap.value(mnemonic) ? flagsNZVC : 0;
+    }
+}
+
+int Peephole::flagsSet(EMnemonic mnemonic)
+{
+    switch (mnemonic) {
+    case ADDA: case ADDX: case SUBA: case SUBX: case ADDSP: case SUBSP:
+    case CPA: case CPX: case ASLA: case ASLX: case RETTR:
+        return flagsNZVC;
+    case ASRA: case ASRX: return flagN | flagZ | flagC;
+    case NEGA: case NEGX: return flagN | flagZ | flagV;
+    case LDA: case LDX: case LDBYTEA: case LDBYTEX:
+    case ANDA: case ANDX: case ORA: case ORX: case NOTA: case NOTX:
+        return flagN | flagZ;
+    case ROLA: case ROLX: case RORA: case RORX: return flagC;
+    default: return 0;
+    }
+}
+
+bool Peephole::flagsDeadAfter(const QList<Code *> &program, int index, int flags)
+{
+    // Follow the straight-line code after program[index] until the flags are all set again.
+    // Anything that could lead elsewhere first keeps them live.
+    for (int i = index + 1; i < program.size() && i <= index + 16; i++) {
+        EMnemonic mnemonic;
+        if (UnaryInstruction *unary = dynamic_cast<UnaryInstruction *>(program[i])) {
+            mnemonic = unary->mnemonic;
+        }
+        else if (NonUnaryInstruction *nonUnary = dynamic_cast<NonUnaryInstruction *>(program[i])) {
+            mnemonic = nonUnary->mnemonic;
+        }
+        else {
+            return false; // Falls into data
+        }
+        if (mnemonic == STOP) {
+            return true;
+        }
+        if (flagsRead(mnemonic) & flags) {
+            return false;
+        }
+        flags &= ~flagsSet(mnemonic);
+        if (flags == 0) {
+            return true;
+        }
+        if (FlowGraph::isBranch(mnemonic) || mnemonic == CALL || (mnemonic >= RET0 && mnemonic <= RET7)) {
+            return false;
+        }
+    }
+    return false;
+}
+
+QString Peephole::instructionLine(const QString &symbolDef, EMnemonic mnemonic, const QString &operand,
+                                  EAddrMode addressingMode, const QString &comment)
+{
+    QString symbolStr = symbolDef.isEmpty() ? "" : symbolDef + ":";
+    QString lineStr = QString("%1%2%3%4")
+                      .arg(symbolStr, -9, QLatin1Char(' '))
+                      .arg(Pep::enumToMnemonMap.value(mnemonic), -8, QLatin1Char(' '))
+                      .arg(operand + "," + Pep::intToAddrMode(addressingMode), -12)
+                      .arg(comment);
+    while (lineStr.endsWith(' ')) {
+        lineStr.chop(1);
+    }
+    return lineStr;
+}
+
+bool Peephole::optimize(const QStringList &sourceCodeList, QStringList &optimizedList, Report &report,
+                        QList<int> &objectCodeBefore, QList<int> &objectCodeAfter, QString &errorString)
+{
+    report.branchesToNextRemoved = 0;
+    report.stackAdjustmentsCombined = 0;
+    report.reloadsRemoved = 0;
+    report.branchesThreaded = 0;
+
+    QVector<Asm::ParsedLine> cache;
+    QList<Code *> codeList;
+    if (!assemble(sourceCodeList, cache, codeList, objectCodeBefore, errorString)) {
+        Asm::clearParsedLines(cache);
+        return false;
+    }
+    report.bytesBefore = objectCodeBefore.size();
+
+    // Rules that remove bytes would break numeric addresses: numeric operands in the direct,
+    // indirect and indexed modes and of branches, and any numeric immediate operand or .WORD
+    // value inside the program, which may be a pointer. The immediate operands of ADDSP and
+    // SUBSP are stack sizes, not addresses.
+    report.sizeChangesAllowed = true;
+    for (int i = 0; i < codeList.size(); i++) {
+        if (NonUnaryInstruction *instr = dynamic_cast<NonUnaryInstruction *>(codeList[i])) {
+            if (instr->argument->isSymbolRef()) {
+                continue;
+            }
+            if (instr->addressingMode == D || instr->addressingMode == N || instr->addressingMode == X
+                || FlowGraph::isBranch(instr->mnemonic) || instr->mnemonic == CALL) {
+                report.sizeChangesAllowed = false;
+            }
+            else if (instr->addressingMode == I && instr->mnemonic != ADDSP && instr->mnemonic != SUBSP
+                     && instr->argument->getArgumentValue() < Pep::byteCount) {
+                report.sizeChangesAllowed = false;
+            }
+        }
+        else if (DotWord *dotWord = dynamic_cast<DotWord *>(codeList[i])) {
+            if (!dotWord->argument->isSymbolRef() && dotWord->argument->getArgumentValue() < Pep::byteCount) {
+                report.sizeChangesAllowed = false;
+            }
+        }
+    }
+
+    optimizedList = sourceCodeList;
+    for (int pass = 0; pass < 100; pass++) {
+        // Instructions and data in address order, without comments, blank lines and equates
+        QList<Code *> program;
+        QHash<QString, NonUnaryInstruction *> labeledBranches;
+        for (int i = 0; i < codeList.size(); i++) {
+            if (dynamic_cast<CommentOnly *>(codeList[i]) == 0 && dynamic_cast<BlankLine *>(codeList[i]) == 0
+                && dynamic_cast<DotEquate *>(codeList[i]) == 0) {
+                program.append(codeList[i]);
+            }
+            NonUnaryInstruction *instr = dynamic_cast<NonUnaryInstruction *>(codeList[i]);
+            if (instr != 0 && instr->mnemonic == BR && instr->addressingMode == I && instr->argument->isSymbolRef()
+                && !instr->symbolDef.isEmpty()) {
+                labeledBranches.insert(instr->symbolDef, instr);
+            }
+        }
+
+        Rewrites rewrites;
+        for (int i = 0; i < program.size(); i++) {
+            NonUnaryInstruction *instr = dynamic_cast<NonUnaryInstruction *>(program[i]);
+            if (instr == 0 || rewrites.touched.contains(instr)) {
+                continue;
+            }
+            NonUnaryInstruction *next = i + 1 < program.size() ? dynamic_cast<NonUnaryInstruction *>(program[i + 1]) : 0;
+            if (next != 0 && rewrites.touched.contains(next)) {
+                next = 0;
+            }
+            bool symbolicBranch = FlowGraph::isBranch(instr->mnemonic) && instr->addressingMode == I && instr->argument->isSymbolRef();
+
+            // Branch to the next instruction
+            if (symbolicBranch && report.sizeChangesAllowed && instr->symbolDef.isEmpty()
+                && Pep::symbols.at(Pep::symbolId(instr->argument->getArgumentString())).kind == K_LABEL
+                && instr->argument->getArgumentValue() == instr->memAddress + 3) {
+                rewrites.removedLines.insert(instr->sourceCodeLine);
+                rewrites.touched.insert(instr);
+                report.branchesToNextRemoved++;
+                continue;
+            }
+
+            // Branch to a branch
+            if (symbolicBranch && labeledBranches.contains(instr->argument->getArgumentString())) {
+                NonUnaryInstruction *target = labeledBranches.value(instr->argument->getArgumentString());
+                QString destination = target->argument->getArgumentString();
+                if (target != instr && destination != instr->argument->getArgumentString()) {
+                    rewrites.replacedLines.insert(instr->sourceCodeLine,
+                                                  instructionLine(instr->symbolDef, instr->mnemonic, destination,
+                                                                  instr->addressingMode, instr->comment));
+                    rewrites.touched.insert(instr);
+                    report.branchesThreaded++;
+                    continue;
+                }
+            }
+
+            if (next == 0 || !next->symbolDef.isEmpty() || !report.sizeChangesAllowed) {
+                continue;
+            }
+
+            // Adjacent stack adjustments, unless trace tags describe them
+            if ((instr->mnemonic == ADDSP || instr->mnemonic == SUBSP) && (next->mnemonic == ADDSP || next->mnemonic == SUBSP)
+                && instr->addressingMode == I && next->addressingMode == I
+                && !instr->comment.contains('#') && !next->comment.contains('#')
+                && flagsDeadAfter(program, i + 1, flagsNZVC)) {
+                int first = instr->argument->getArgumentValue();
+                int second = next->argument->getArgumentValue();
+                if (instr->mnemonic == next->mnemonic) {
+                    QString comment = instr->comment.isEmpty() ? next->comment : instr->comment;
+                    rewrites.replacedLines.insert(instr->sourceCodeLine,
+                                                  instructionLine(instr->symbolDef, instr->mnemonic,
+                                                                  QString::number((first + second) & 0xffff), I, comment));
+                    rewrites.removedLines.insert(next->sourceCodeLine);
+                }
+                else if (first == second && instr->symbolDef.isEmpty()) {
+                    rewrites.removedLines.insert(instr->sourceCodeLine);
+                    rewrites.removedLines.insert(next->sourceCodeLine);
+                }
+                else {
+                    continue;
+                }
+                rewrites.touched.insert(instr);
+                rewrites.touched.insert(next);
+                report.stackAdjustmentsCombined++;
+                continue;
+            }
+
+            // Load of the value just stored
+            if (((instr->mnemonic == STA && next->mnemonic == LDA) || (instr->mnemonic == STX && next->mnemonic == LDX))
+                && instr->addressingMode == next->addressingMode
+                && (instr->addressingMode == D || instr->addressingMode == S
+                    || instr->addressingMode == X || instr->addressingMode == SX)
+                && instr->argument->getArgumentString() == next->argument->getArgumentString()
+                && flagsDeadAfter(program, i + 1, flagN | flagZ)) {
+                rewrites.removedLines.insert(next->sourceCodeLine);
+                rewrites.touched.insert(instr);
+                rewrites.touched.insert(next);
+                report.reloadsRemoved++;
+                continue;
+            }
+        }
+
+        if (rewrites.touched.isEmpty()) {
+            break;
+        }
+        QStringList rewritten;
+        for (int i = 0; i < optimizedList.size(); i++) {
+            if (rewrites.removedLines.contains(i)) {
+                continue;
+            }
+            rewritten.append(rewrites.replacedLines.value(i, optimizedList.at(i)));
+        }
+        optimizedList = rewritten;
+        if (!assemble(optimizedList, cache, codeList, objectCodeAfter, errorString)) {
+            errorString = "The optimized program does not assemble. " + errorString;
+            Asm::clearParsedLines(cache);
+            return false;
+        }
+    }
+    if (optimizedList == sourceCodeList) {
+        objectCodeAfter = objectCodeBefore;
+    }
+    report.bytesAfter = objectCodeAfter.size();
+    Asm::clearParsedLines(cache);
+    return true;
+}
+
+bool Peephole::countInstructions(const QList<int> &objectCode, QIODevice *inputDevice, const QString &input,
+                                 int maxSteps, int &instructionCount, QString &errorString)
+{
+    QVector<int> savedMem = Sim::Mem;
+    bool nBit = Sim::nBit, zBit = Sim::zBit, vBit = Sim::vBit, cBit = Sim::cBit;
+    int accumulator = Sim::accumulator;
+    int indexRegister = Sim::indexRegister;
+    int stackPointer = Sim::stackPointer;
+    int programCounter = Sim::programCounter;
+    bool trapped = Sim::trapped;
+    QIODevice *savedInputDevice = Sim::inputDevice;
+    QByteArray inputChunk = Sim::inputChunk;
+    int inputChunkPos = Sim::inputChunkPos;
+    QString inputBuffer = Sim::inputBuffer;
+    QString outputBuffer = Sim::outputBuffer;
+    QIODevice *outputDevice = Sim::outputDevice;
+
+    for (int i = 0; i < Pep::romStartAddress; i++) {
+        Sim::Mem[i] = 0;
+    }
+    Sim::loadMem(objectCode);
+    Sim::nBit = Sim::zBit = Sim::vBit = Sim::cBit = false;
+    Sim::accumulator = 0;
+    Sim::indexRegister = 0;
+    Sim::stackPointer = Sim::readWord(Pep::dotBurnArgument - 7);
+    Sim::programCounter = 0x0000;
+    Sim::trapped = false;
+    if (inputDevice != NULL) {
+        inputDevice->seek(0);
+        Sim::setInputDevice(inputDevice);
+        Sim::inputBuffer = "";
+    }
+    else {
+        Sim::setInputDevice(NULL);
+        Sim::inputBuffer = input;
+    }
+    Sim::outputDevice = 0;
+    Sim::outputBuffer = "";
+
+    bool ok = false;
+    errorString = "The program did not stop.";
+    for (instructionCount = 0; instructionCount < maxSteps; ) {
+        if (!Sim::vonNeumannStep(errorString)) {
+            break;
+        }
+        instructionCount++;
+        if (Pep::decodeMnemonic[Sim::instructionSpecifier] == STOP) {
+            ok = true;
+            break;
+        }
+    }
+
+    Sim::Mem = savedMem;
+    Sim::nBit = nBit; Sim::zBit = zBit; Sim::vBit = vBit; Sim::cBit = cBit;
+    Sim::accumulator = accumulator;
+    Sim::indexRegister = indexRegister;
+    Sim::stackPointer = stackPointer;
+    Sim::programCounter = programCounter;
+    Sim::trapped = trapped;
+    Sim::setInputDevice(savedInputDevice);
+    Sim::inputChunk = inputChunk;
+    Sim::inputChunkPos = inputChunkPos;
+    Sim::inputBuffer = inputBuffer;
+    Sim::outputBuffer = outputBuffer;
+    Sim::outputDevice = outputDevice;
+    return ok;
+}
@@ -0,0 +1,89 @@
+// File: peephole.h
+/*
+    Pep8-1 is a virtual machine for writing machine language and assembly
+    language programs.
+    
+    Copyright (C) 2009  J. Stanley Warford, Pepperdine University
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef PEEPHOLE_H
+#define PEEPHOLE_H
+
+#include <QIODevice>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include "asm.h"
+#include "enu.h"
+
+class Code;
+
+// The peephole optimizer rewrites the source of a program, one pass at a time over the code
+// list of its assembly, until no rule applies:
+// - A branch to the instruction that follows it is removed.
+// - Adjacent ADDSP or SUBSP instructions are combined, and a SUBSP undone by an ADDSP is removed.
+// - A load of the value just stored from the same operand is removed.
+// - A branch to a BR is retargeted to the destination of the BR.
+// A rule that removes bytes moves every later address, so such rules are only applied to
+// programs that name every address they use with a symbol. Rules that drop a flag setting
+// are only applied when the flags are set again before anything reads them.
+class Peephole
+{
+public:
+    struct Report
+    {
+        int branchesToNextRemoved;
+        int stackAdjustmentsCombined;
+        int reloadsRemoved;
+        int branchesThreaded;
+        int bytesBefore;
+        int bytesAfter;
+        bool sizeChangesAllowed; // False if the program uses numeric addresses
+    };
+
+    static bool optimize(const QStringList &sourceCodeList, QStringList &optimizedList, Report &report,
+                         QList<int> &objectCodeBefore, QList<int> &objectCodeAfter, QString &errorString);
+    // Post: If sourceCodeList assembles as a program, optimizedList is the optimized source,
+    // report counts the rewrites and the object code sizes, objectCodeBefore and objectCodeAfter
+    // are the object code of both, and true is returned.
+    // Post: Otherwise false is returned and errorString is the first assembly error.
+    // Post: The symbol table and byte counts are those of the last assembly, so the caller
+    // must assemble again before it uses them.
+
+    static bool countInstructions(const QList<int> &objectCode, QIODevice *inputDevice, const QString &input,
+                                  int maxSteps, int &instructionCount, QString &errorString);
+    // Pre: The OS is installed in memory.
+    // Pre: inputDevice is NULL or is open for reading.
+    // Post: objectCode is loaded at address 0 with zeroed RAM and run until it executes STOP, and
+    // instructionCount is the number of instructions it executed, including the OS. Its input is
+    // read from the start of inputDevice if it is set, as by a batch run, and from input otherwise.
+    // Post: If the program fails or does not stop within maxSteps, false is returned and
+    // errorString is set.
+    // Post: Memory, the CPU registers and the simulator input and output are restored.
+
+private:
+    static bool assemble(const QStringList &sourceCodeList, QVector<Asm::ParsedLine> &cache, QList<Code *> &codeList,
+                         QList<int> &objectCode, QString &errorString);
+    static int flagsRead(Enu::EMnemonic mnemonic);
+    static int flagsSet(Enu::EMnemonic mnemonic);
+    static bool flagsDeadAfter(const QList<Code *> &program, int index, int flags);
+    static QString instructionLine(const QString &symbolDef, Enu::EMnemonic mnemonic, const QString &operand,
+                                   Enu::EAddrMode addressingMode, const QString &comment);
+};
+
+#endif // PEEPHOLE_H
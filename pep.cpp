@@ -149,6 +149,20 @@ QString Pep::getSystem() {
     #endif
 }
 
+int Pep::hexDigitValue(QChar ch) {
+    ushort c = ch.unicode();
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    return -1;
+}
+
 
 // Maps between mnemonic enums and strings
 QMap<Enu::EMnemonic, QString> Pep::enumToMnemonMap;
@@ -387,17 +401,121 @@ void Pep::initAddrModesMap()
 }
 
 // The symbol table
-QMap<QString, int> Pep::symbolTable;
-QMap<QString, bool> Pep::adjustSymbolValueForBurn;
+QHash<QString, int> Pep::symbolIds;
+QVector<Pep::Symbol> Pep::symbols;
+
+int Pep::internSymbol(const QString &name)
+{
+    QHash<QString, int>::const_iterator i = symbolIds.constFind(name);
+    if (i != symbolIds.constEnd()) {
+        return i.value();
+    }
+    Symbol symbol;
+    symbol.name = name;
+    symbol.kind = K_UNDEFINED;
+    symbol.value = 0;
+    symbol.adjustForBurn = false;
+    symbol.format = F_NONE;
+    symbol.formatMultiplier = 1;
+    symbol.isBlockSymbol = false;
+    symbol.isEquateSymbol = false;
+    symbol.definitionLineNum = -1;
+    symbols.append(symbol);
+    symbolIds.insert(name, symbols.size() - 1);
+    return symbols.size() - 1;
+}
+
+int Pep::symbolId(const QString &name)
+{
+    return symbolIds.value(name, -1);
+}
+
+bool Pep::isSymbolDefined(const QString &name)
+{
+    int id = symbolId(name);
+    return id >= 0 && symbols.at(id).kind != K_UNDEFINED;
+}
+
+int Pep::symbolValue(const QString &name)
+{
+    int id = symbolId(name);
+    return id >= 0 ? symbols.at(id).value : 0;
+}
+
+void Pep::defineSymbol(const QString &name, int value, Enu::ESymbolKind kind, int lineNum)
+{
+    Symbol &symbol = symbols[internSymbol(name)];
+    symbol.kind = kind;
+    symbol.value = value;
+    symbol.adjustForBurn = kind == K_LABEL;
+    symbol.definitionLineNum = lineNum;
+}
+
+void Pep::referenceSymbol(int id, int lineNum)
+{
+    symbols[id].referenceLineNums.append(lineNum);
+}
+
+QList<int> Pep::sortedSymbolIds()
+{
+    QMap<QString, int> sorted;
+    for (int i = 0; i < symbols.size(); i++) {
+        if (symbols.at(i).kind != K_UNDEFINED) {
+            sorted.insert(symbols.at(i).name, i);
+        }
+    }
+    return sorted.values();
+}
+
+Pep::CrossReferenceIndex Pep::crossReferenceIndex()
+{
+    CrossReferenceIndex index;
+    for (int i = 0; i < symbols.size(); i++) {
+        CrossReference &crossReference = index[symbols.at(i).name];
+        crossReference.definitionLineNum = symbols.at(i).definitionLineNum;
+        crossReference.referenceLineNums = symbols.at(i).referenceLineNums;
+    }
+    return index;
+}
+
+QStringList Pep::unusedSymbols(const CrossReferenceIndex &index)
+{
+    QStringList unused;
+    QMapIterator<QString, CrossReference> i(index);
+    while (i.hasNext()) {
+        i.next();
+        if (i.value().definitionLineNum >= 0 && i.value().referenceLineNums.isEmpty()) {
+            unused.append(i.key());
+        }
+    }
+    return unused;
+}
+
+void Pep::adjustSymbolValuesForBurn(int addressDelta)
+{
+    for (int i = 0; i < symbols.size(); i++) {
+        if (symbols.at(i).adjustForBurn) {
+            symbols[i].value += addressDelta;
+        }
+    }
+}
+
+void Pep::clearSymbolTable()
+{
+    symbolIds.clear();
+    symbols.clear();
+    globalStructSymbols.clear();
+    symbolTraceList.clear();
+    blockSymbols.clear();
+    equateSymbols.clear();
+}
 
 // The trace tag tables
-QMap<QString, Enu::ESymbolFormat> Pep::symbolFormat;
-QMap<QString, int> Pep::symbolFormatMultiplier;
 QMap<QString, QStringList> Pep::globalStructSymbols;
 
 QMap<int, QStringList> Pep::symbolTraceList; // Key is memory address
-QStringList Pep::blockSymbols;
-QStringList Pep::equateSymbols;
+QList<int> Pep::blockSymbols;
+QList<int> Pep::equateSymbols;
 
 // Map from instruction memory address to assembler listing line
 QMap<int, int> *Pep::memAddrssToAssemblerListing;
@@ -23,6 +23,7 @@
 #define PEP_H
 
 #include <QMap>
+#include <QHash>
 #include <QSet>
 #include <QString>
 #include <QStringList>
@@ -93,6 +94,8 @@ public:
     static QString resToString(QString fileName);
     // Function for getting the system we're running on
     static QString getSystem();
+    // Function for decoding one character of hexadecimal object code
+    static int hexDigitValue(QChar ch);
 
     // Maps between mnemonic enums and strings
     static QMap<Enu::EMnemonic, QString> enumToMnemonMap;
@@ -111,13 +114,70 @@ public:
     static void initAddrModesMap();
 
     // The symbol table
-    static QMap<QString, int> symbolTable;
-    static QMap<QString, bool> adjustSymbolValueForBurn;
+    // Every symbol name is interned to an integer id the first time it is defined or referenced.
+    // symbolIds maps the name to its id, and symbols[id] holds everything the assembler and the
+    // memory tracer know about the symbol, so that lookups by id are array indexing.
+    struct Symbol
+    {
+        QString name;
+        Enu::ESymbolKind kind;
+        int value;
+        bool adjustForBurn;
+        Enu::ESymbolFormat format; // From a format trace tag, F_NONE if there is none.
+        int formatMultiplier;
+        bool isBlockSymbol; // The .BLOCK that defines the symbol has a trace tag.
+        bool isEquateSymbol; // The .EQUATE that defines the symbol has a format trace tag.
+        int definitionLineNum; // Source line of the definition, -1 if the symbol is not defined.
+        QList<int> referenceLineNums; // Source lines whose operand is the symbol, in source order.
+    };
+    static QHash<QString, int> symbolIds;
+    static QVector<Symbol> symbols;
+
+    static int internSymbol(const QString &name);
+    // Post: Returns the id of name, adding an undefined entry for it if it has none.
+
+    static int symbolId(const QString &name);
+    // Post: Returns the id of name, or -1 if name has never been defined or referenced.
+
+    static bool isSymbolDefined(const QString &name);
+    // Post: Returns true if name is defined as a label or by .EQUATE.
+
+    static int symbolValue(const QString &name);
+    // Post: Returns the value of name, or 0 if name is not defined.
+
+    static void defineSymbol(const QString &name, int value, Enu::ESymbolKind kind, int lineNum);
+    // Post: name is defined on source line lineNum with value and kind, and is adjusted for .BURN
+    // if it is a label.
+
+    static void referenceSymbol(int id, int lineNum);
+    // Post: lineNum is appended to the reference lines of symbol id.
+
+    static QList<int> sortedSymbolIds();
+    // Post: Returns the ids of the defined symbols in alphabetical order of their names.
+
+    static void adjustSymbolValuesForBurn(int addressDelta);
+    // Post: addressDelta is added to the value of every symbol that is adjusted for .BURN.
+
+    static void clearSymbolTable();
+    // Post: The symbol table and the trace tag tables are cleared.
+
+    // The cross-reference index
+    // For each symbol, the source line that defines it and the source lines that use it,
+    // keyed and so sorted by name. Navigation and the unused symbol report work from it.
+    struct CrossReference
+    {
+        int definitionLineNum; // -1 if the symbol is used but not defined.
+        QList<int> referenceLineNums;
+    };
+    typedef QMap<QString, CrossReference> CrossReferenceIndex;
+
+    static CrossReferenceIndex crossReferenceIndex();
+    // Post: Returns the cross-reference index of the symbol table, that is of the last assembly.
+
+    static QStringList unusedSymbols(const CrossReferenceIndex &index);
+    // Post: Returns the symbols of index that are defined but never used, in alphabetical order.
 
     // The trace tag tables
-    static QMap<QString, Enu::ESymbolFormat> symbolFormat;
-    static QMap<QString, int> symbolFormatMultiplier;
-
     // This map is for global structs. The key is the symbol defined on the .BLOCK line
     // and QStringList contains the list of symbols from the symbol tags in the .BLOCK comment.
     static QMap<QString, QStringList> globalStructSymbols;
@@ -127,8 +187,9 @@ public:
     // The stringlist would contain next and data
     static QMap<int, QStringList> symbolTraceList;
 
-    static QStringList blockSymbols;
-    static QStringList equateSymbols;
+    // Ids of the symbols with trace tags on their .BLOCK and .EQUATE lines, in source order.
+    static QList<int> blockSymbols;
+    static QList<int> equateSymbols;
 
     // Map from instruction memory address to assembler listing line
     // These pointers are set to the addresses of the program or OS maps
@@ -26,6 +26,7 @@ HEADERS += mainwindow.h \
     assemblerlistingpane.h \
     memorytracepane.h \
     memorydumppane.h \
+    memorydumpmodel.h \
     inputpane.h \
     outputpane.h \
     terminalpane.h \
@@ -38,6 +39,7 @@ HEADERS += mainwindow.h \
     pep.h \
     helpdialog.h \
     listingtracepane.h \
+    listingtracemodel.h \
     asm.h \
     code.h \
     argument.h \
@@ -45,10 +47,17 @@ HEADERS += mainwindow.h \
     enu.h \
     pephighlighter.h \
     cpphighlighter.h \
+    incrementalhighlighter.h \
     aboutpep.h \
     memorycellgraphicsitem.h \
     stackframefsm.h \
-    byteconverterinstr.h
+    byteconverterinstr.h \
+    arena.h \
+    objectfile.h \
+    linker.h \
+    peephole.h \
+    flowgraph.h \
+    disassembler.h
 FORMS += mainwindow.ui \
     sourcecodepane.ui \
     objectcodepane.ui \
@@ -76,6 +85,7 @@ SOURCES += main.cpp \
     assemblerlistingpane.cpp \
     memorytracepane.cpp \
     memorydumppane.cpp \
+    memorydumpmodel.cpp \
     inputpane.cpp \
     outputpane.cpp \
     terminalpane.cpp \
@@ -87,14 +97,22 @@ SOURCES += main.cpp \
     pep.cpp \
     helpdialog.cpp \
     listingtracepane.cpp \
+    listingtracemodel.cpp \
     asm.cpp \
     code.cpp \
     sim.cpp \
     pephighlighter.cpp \
     cpphighlighter.cpp \
+    incrementalhighlighter.cpp \
     aboutpep.cpp \
     memorycellgraphicsitem.cpp \
     stackframefsm.cpp \
-    byteconverterinstr.cpp
+    byteconverterinstr.cpp \
+    arena.cpp \
+    objectfile.cpp \
+    linker.cpp \
+    peephole.cpp \
+    flowgraph.cpp \
+    disassembler.cpp
 RESOURCES += pep8resources.qrc \
     helpresources.qrc
@@ -22,33 +22,27 @@
 #ifndef PEPHIGHLIGHTER_H
 #define PEPHIGHLIGHTER_H
 
-#include <QSyntaxHighlighter>
+#include "incrementalhighlighter.h"
 
-#include <QHash>
+#include <QSet>
 #include <QTextCharFormat>
 
 QT_BEGIN_NAMESPACE
 class QTextDocument;
 QT_END_NAMESPACE
 
-class PepHighlighter : public QSyntaxHighlighter
+// Highlights Pep/8 source with the assembler's own lexer, so that a line is scanned once
+// instead of once per pattern.
+class PepHighlighter : public IncrementalHighlighter
 {
 public:
     PepHighlighter(QTextDocument *parent = 0);
 
 protected:
-    void highlightBlock(const QString &text);
+    void highlightLine(const QString &text);
 
 private:
-    struct HighlightingRule
-    {
-        QRegExp pattern;
-        QTextCharFormat format;
-    };
-    QVector<HighlightingRule> highlightingRules;
-
-    QRegExp commentStartExpression;
-    QRegExp commentEndExpression;
+    QSet<QString> dotCommands;
 
     QTextCharFormat oprndFormat;
     QTextCharFormat dotFormat;
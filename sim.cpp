@@ -40,6 +40,11 @@ int Sim::operandDisplayFieldWidth;
 QString Sim::inputBuffer;
 QString Sim::outputBuffer;
 
+QIODevice *Sim::inputDevice = NULL;
+QIODevice *Sim::outputDevice = NULL;
+QByteArray Sim::inputChunk;
+int Sim::inputChunkPos = 0;
+
 QSet<int> Sim::modifiedBytes;
 bool Sim::trapped;
 bool Sim::tracingTraps;
@@ -66,12 +71,79 @@ int Sim::nzvcToInt()
     return i;
 }
 
-void Sim::loadMem(QList<int> objectCodeList) {
-    for (int i = 0; objectCodeList.length() > 0; i++) {
-        Mem[i] = objectCodeList.takeAt(0);
+void Sim::setInputDevice(QIODevice *device)
+{
+    inputDevice = device;
+    inputChunk.clear();
+    inputChunkPos = 0;
+}
+
+bool Sim::readInputByte(int &value)
+{
+    if (inputDevice != NULL) {
+        if (inputChunkPos >= inputChunk.size()) {
+            inputChunk = inputDevice->read(inputChunkSize);
+            inputChunkPos = 0;
+            if (inputChunk.isEmpty()) {
+                return false;
+            }
+        }
+        value = static_cast<unsigned char>(inputChunk.at(inputChunkPos++));
+        return true;
+    }
+    if (inputBuffer.size() != 0) {
+        value = QChar(inputBuffer[0]).toLatin1();
+        value += value < 0 ? 256 : 0;
+        inputBuffer.remove(0, 1);
+        return true;
+    }
+    return false;
+}
+
+void Sim::loadMem(const QList<int> &objectCodeList, int address) {
+    int *mem = Mem.data();
+    for (int i = 0; i < objectCodeList.length(); i++) {
+        mem[(address + i) & 0xffff] = objectCodeList.at(i);
     }
 }
 
+bool Sim::loadObjectCode(const QString &objectText, int address, int &byteCount, int &errorOffset)
+{
+    const QChar *text = objectText.constData();
+    const int length = objectText.length();
+    // Bytes are decoded into a local buffer so that Mem is untouched by malformed object code.
+    QVector<int> bytes;
+    bytes.reserve(length / 3 + 1);
+    byteCount = 0;
+    for (int i = 0; i < length; i += 3) {
+        if (i + 1 < length && text[i] == QChar('z') && text[i + 1] == QChar('z')) {
+            int *mem = Mem.data();
+            for (int j = 0; j < bytes.size(); j++) {
+                mem[(address + j) & 0xffff] = bytes.at(j);
+            }
+            byteCount = bytes.size();
+            return true;
+        }
+        if (i + 2 >= length) {
+            errorOffset = i;
+            return false;
+        }
+        int high = Pep::hexDigitValue(text[i]);
+        if (high < 0) {
+            errorOffset = i;
+            return false;
+        }
+        int low = Pep::hexDigitValue(text[i + 1]);
+        if (low < 0) {
+            errorOffset = i + 1;
+            return false;
+        }
+        bytes.append(high * 16 + low);
+    }
+    errorOffset = length;
+    return false;
+}
+
 int Sim::add(int lhs, int rhs)
 {
     return (lhs + rhs) & 0xffff;
@@ -263,6 +335,85 @@ int Sim::cellSize(Enu::ESymbolFormat symbolFormat)
     }
 }
 
+// Character loop of the system loader of the default OS, from getChar to BR getChar
+static const struct {
+    Enu::EMnemonic mnemonic;
+    Enu::EAddrMode addrMode;
+} loaderLoop[] = {
+    { CHARI, D }, { LDA, D }, { CPA, I }, { BREQ, I }, { CPA, I }, { BRLE, I }, { ADDA, I },
+    { ASLA, NONE }, { ASLA, NONE }, { ASLA, NONE }, { ASLA, NONE }, { STBYTEA, D },
+    { CHARI, D }, { LDA, D }, { CPA, I }, { BRLE, I }, { ADDA, I }, { ANDA, I }, { ORA, D },
+    { STBYTEA, X }, { ADDX, I }, { CHARI, D }, { BR, I }
+};
+static const int loaderLoopLength = sizeof(loaderLoop) / sizeof(loaderLoop[0]);
+
+static bool isLoaderLoop(int address, int &wordBuff, int &wordTemp)
+// Post: Returns true if the loader character loop starts at address, with wordBuff and
+// wordTemp set to the addresses of its buffers.
+{
+    int operand[loaderLoopLength];
+    int addr = address;
+    for (int i = 0; i < loaderLoopLength; i++) {
+        int instructionSpecifier = Sim::readByte(addr);
+        if (Pep::decodeMnemonic[instructionSpecifier] != loaderLoop[i].mnemonic) {
+            return false;
+        }
+        if (loaderLoop[i].addrMode == NONE) {
+            addr = Sim::add(addr, 1);
+        }
+        else {
+            if (Pep::decodeAddrMode[instructionSpecifier] != loaderLoop[i].addrMode) {
+                return false;
+            }
+            operand[i] = Sim::readWord(Sim::add(addr, 1));
+            addr = Sim::add(addr, 3);
+        }
+    }
+    wordBuff = operand[1];
+    wordTemp = operand[18];
+    return operand[0] == wordBuff + 1 && operand[12] == wordBuff + 1 && operand[21] == wordBuff + 1 &&
+            operand[13] == wordBuff && operand[11] == wordTemp + 1 &&
+            operand[2] == 'z' && operand[4] == '9' && operand[14] == '9' &&
+            operand[6] == 9 && operand[16] == 9 && operand[17] == 0x000F &&
+            operand[19] == 0 && operand[20] == 1 &&
+            operand[5] == Sim::add(address, 21) && operand[15] == Sim::add(address, 43) && operand[22] == address;
+}
+
+static int loaderDigit(int ch)
+// Post: Returns ch as the loader converts a hex character, correct in the low nybble only.
+{
+    return ch <= '9' ? ch : ch + 9;
+}
+
+int Sim::runNativeLoader()
+{
+    int wordBuff;
+    int wordTemp;
+    if (inputDevice != NULL || !isLoaderLoop(programCounter, wordBuff, wordTemp) || readByte(wordBuff) != 0) {
+        return 0;
+    }
+    // Stores must not reach the loader buffers or the loop itself.
+    int limit = qMin(qMin(wordBuff, wordTemp), programCounter);
+    modifiedBytes.clear();
+    int count = 0;
+    int pos = 0;
+    int byteCount = inputBuffer.size();
+    while (pos + 3 < byteCount && indexRegister < limit) {
+        int ch1 = static_cast<unsigned char>(inputBuffer.at(pos).toLatin1());
+        int next = static_cast<unsigned char>(inputBuffer.at(pos + 3).toLatin1());
+        if (ch1 == 'z' || next == 'z') {
+            break;
+        }
+        int ch2 = static_cast<unsigned char>(inputBuffer.at(pos + 1).toLatin1());
+        writeByte(indexRegister, ((loaderDigit(ch1) << 4) & 0xF0) | (loaderDigit(ch2) & 0x0F));
+        indexRegister++;
+        pos += 3; // Two hex characters and the blank or <LF> that follows them
+        count++;
+    }
+    inputBuffer.remove(0, pos);
+    return count;
+}
+
 bool Sim::vonNeumannStep(QString &errorString)
 {
     modifiedBytes.clear();
@@ -437,12 +588,8 @@ bool Sim::vonNeumannStep(QString &errorString)
         programCounter = operand; // PC <- Oprnd
         return true;
     case CHARI:
-        if (Sim::inputBuffer.size() != 0) {
-            QString ch = Sim::inputBuffer.left(1);
-            Sim::inputBuffer.remove(0, 1);
-            int value = QChar(ch[0]).toLatin1();
-            value += value < 0 ? 256 : 0;
-            Sim::writeByteOprnd(addrMode, value);
+        if (Sim::readInputByte(temp)) {
+            Sim::writeByteOprnd(addrMode, temp);
             operand = readByteOprnd(addrMode);
             operandDisplayFieldWidth = 2;
         }
@@ -457,7 +604,12 @@ bool Sim::vonNeumannStep(QString &errorString)
     case CHARO:
         operand = readByteOprnd(addrMode);
         operandDisplayFieldWidth = 2;
-        Sim::outputBuffer = QString(operand);
+        if (Sim::outputDevice != NULL) {
+            Sim::outputDevice->putChar(static_cast<char>(operand));
+        }
+        else {
+            Sim::outputBuffer = QString(operand);
+        }
         return true;
     case CPA:
         operand = readWordOprnd(addrMode);
@@ -679,3 +831,31 @@ bool Sim::vonNeumannStep(QString &errorString)
     }
     return false;
 }
+
+bool Sim::runTrap(QString &errorString, int maxInstructions, bool stopForInput)
+{
+    QSet<int> trapModifiedBytes;
+    QString trapOutput;
+    EMnemonic mnemonic;
+    for (int i = 0; i < maxInstructions; i++) {
+        if (stopForInput && Pep::decodeMnemonic[readByte(programCounter)] == CHARI && inputBuffer.isEmpty()) {
+            break;
+        }
+        if (!vonNeumannStep(errorString)) {
+            modifiedBytes.unite(trapModifiedBytes);
+            outputBuffer = trapOutput;
+            return false;
+        }
+        // CHARO replaces the output buffer, so each character is collected as it is output.
+        trapModifiedBytes.unite(modifiedBytes);
+        trapOutput.append(outputBuffer);
+        outputBuffer = "";
+        mnemonic = Pep::decodeMnemonic[instructionSpecifier];
+        if (mnemonic == RETTR || mnemonic == STOP) {
+            break;
+        }
+    }
+    modifiedBytes = trapModifiedBytes;
+    outputBuffer = trapOutput;
+    return true;
+}
@@ -23,6 +23,8 @@
 #define SIM_H
 
 #include <QVector>
+#include <QByteArray>
+#include <QIODevice>
 #include "enu.h"
 
 class Sim
@@ -43,6 +45,22 @@ public:
     static QString inputBuffer;
     static QString outputBuffer;
 
+    // Streaming batch I/O. When inputDevice is set, CHARI pulls its bytes from the
+    // device one chunk at a time instead of from inputBuffer. When outputDevice is
+    // set, CHARO writes directly to the device and outputBuffer is left empty.
+    static QIODevice *inputDevice;
+    static QIODevice *outputDevice;
+    static QByteArray inputChunk;
+    static int inputChunkPos;
+    static const int inputChunkSize = 4096;
+
+    static void setInputDevice(QIODevice *device);
+    // Post: inputDevice is set to device (possibly NULL) and the chunk buffer is emptied.
+
+    static bool readInputByte(int &value);
+    // Post: If a byte of input is available from inputDevice or inputBuffer, it is consumed,
+    // value is set to its unsigned value, and true is returned. Otherwise false is returned.
+
     static QSet<int> modifiedBytes;
     static bool trapped;
     static bool tracingTraps;
@@ -65,7 +83,16 @@ public:
 
     static int addAndSetNZVC(int lhs, int rhs);
 
-    static void loadMem(QList<int> objectCodeList);
+    static void loadMem(const QList<int> &objectCodeList, int address = 0);
+    // Post: The bytes of objectCodeList are stored in Mem starting at address.
+
+    static bool loadObjectCode(const QString &objectText, int address, int &byteCount, int &errorOffset);
+    // Pre: objectText is object code in the format of the object code pane, two hex digits
+    // and one separator per byte, terminated by zz.
+    // Post: The bytes are decoded in a single pass and stored in Mem starting at address,
+    // and byteCount is the number of bytes stored. If a byte is malformed or zz is missing,
+    // Mem is unchanged, byteCount is 0, false is returned and errorOffset is the offset of
+    // the offending character in objectText.
 
     static int readByte(int memAddr);
     static int readWord(int memAddr);
@@ -91,6 +118,21 @@ public:
 
     static bool vonNeumannStep(QString &errorString);
 
+    static bool runTrap(QString &errorString, int maxInstructions, bool stopForInput);
+    // Pre: The trap instruction or its handler is next to execute.
+    // Post: Instructions are executed until RETTR or STOP has executed, one fails, maxInstructions
+    // have executed or, if stopForInput, CHARI is next with an empty inputBuffer. modifiedBytes is
+    // the set of bytes written by all of them and outputBuffer holds every character they output.
+    // Returns false with errorString set if an instruction fails.
+
+    static int runNativeLoader();
+    // Post: If the program counter is at the top of the character loop of the system loader of the
+    // default OS, the complete byte records of inputBuffer are decoded and stored at the index
+    // register exactly as the loop would store them, except that the last record and the zz
+    // sentinel are left for the loop, so registers and memory end identical to an interpreted
+    // load. modifiedBytes holds the bytes stored, and their number is returned. Returns 0 when
+    // the loop is not recognized or input comes from inputDevice.
+
 };
 
 #endif // SIM_H
@@ -22,15 +22,26 @@
 #include <QList>
 #include <QStringList>
 #include <QTextCursor>
+#include <QTextBlock>
 #include <QPalette>
 #include <QSyntaxHighlighter>
 #include <QFontDialog>
 #include <QKeyEvent>
+#include <QCryptographicHash>
+#include <QDesktopServices>
+#include <QDir>
+#include <QFileInfo>
+#include <QTimer>
+#include <QToolTip>
+#include <QHelpEvent>
+#include <QtConcurrentRun>
 #include "sourcecodepane.h"
 #include "ui_sourcecodepane.h"
 #include "code.h"
 #include "sim.h"
 #include "pep.h"
+#include "objectfile.h"
+#include "flowgraph.h"
 
 // #include <QDebug>
 
@@ -49,67 +60,54 @@ SourceCodePane::SourceCodePane(QWidget *parent) :
 
     ui->label->setFont(QFont(Pep::labelFont, Pep::labelFontSize));
     ui->textEdit->setFont(QFont(Pep::codeFont, Pep::codeFontSize));
+
+    backgroundJob = NULL;
+    backgroundAssemblyEnabled = true;
+    backgroundTimer = new QTimer(this);
+    backgroundTimer->setSingleShot(true);
+    backgroundTimer->setInterval(backgroundDelay);
+    connect(backgroundTimer, SIGNAL(timeout()), this, SLOT(startBackgroundAssembly()));
+    connect(ui->textEdit->document(), SIGNAL(contentsChanged()), this, SLOT(scheduleBackgroundAssembly()));
+    connect(&backgroundWatcher, SIGNAL(finished()), this, SLOT(backgroundAssemblyFinished()));
+    ui->textEdit->viewport()->installEventFilter(this);
 }
 
 SourceCodePane::~SourceCodePane()
 {
+    backgroundWatcher.waitForFinished();
+    if (backgroundJob != NULL) {
+        Asm::clearParsedLines(backgroundJob->parsedLines);
+        delete backgroundJob;
+    }
+    Asm::clearParsedLines(backgroundParsedLines);
+    Asm::clearParsedLines(parsedLines);
+    Asm::clearParsedLines(osParsedLines);
     delete ui;
 }
 
-bool SourceCodePane::assemble()
+bool SourceCodePane::assemble(Enu::EAssembly assembly)
 {
-    QString sourceLine;
     QString errorString;
     QStringList sourceCodeList;
-    Code *code;
     int lineNum = 0;
-    bool dotEndDetected = false;
 
     removeErrorMessages();
-    Asm::listOfReferencedSymbols.clear();
-    Asm::listOfReferencedSymbolLineNums.clear();
     Pep::memAddrssToAssemblerListing->clear();
-    Pep::symbolTable.clear();
-    Pep::adjustSymbolValueForBurn.clear();
-    Pep::symbolFormat.clear();
-    Pep::symbolFormatMultiplier.clear();;
-    Pep::symbolTraceList.clear(); // Does this clear the lists within the map?
-    Pep::globalStructSymbols.clear();
-    Pep::blockSymbols.clear();
-    Pep::equateSymbols.clear();
-    while (!codeList.isEmpty()) {
-        delete codeList.takeFirst();
+    if (!backgroundParsedLines.isEmpty()) {
+        // The latest background check parsed a snapshot at least as recent as the last assembly,
+        // so only the lines edited since that check are parsed again.
+        Asm::clearParsedLines(parsedLines);
+        parsedLines = backgroundParsedLines;
+        backgroundParsedLines.clear();
     }
     QString sourceCode = ui->textEdit->toPlainText();
     sourceCodeList = sourceCode.split('\n');
-    Pep::byteCount = 0;
-    Pep::burnCount = 0;
-    while (lineNum < sourceCodeList.size() && !dotEndDetected) {
-        sourceLine = sourceCodeList[lineNum];
-        if (!Asm::processSourceLine(sourceLine, lineNum, code, errorString, dotEndDetected)) {
-            appendMessageInSourceCodePaneAt(lineNum, errorString);
-            return false;
-        }
-        codeList.append(code);
-        lineNum++;
-    }
-    if (!dotEndDetected) {
-        errorString = ";ERROR: Missing .END sentinel.";
-        appendMessageInSourceCodePaneAt(0, errorString);
+    if (!Asm::assembleProgram(sourceCodeList, parsedLines, codeList, assembly, objectCode, lineNum, errorString)) {
+        appendMessageInSourceCodePaneAt(lineNum, errorString);
         return false;
     }
-    if (Pep::byteCount > 65535) {
-        errorString = ";ERROR: Object code size too large to fit into memory.";
-        appendMessageInSourceCodePaneAt(0, errorString);
-        return false;
-    }
-    for (int i = 0; i < Asm::listOfReferencedSymbols.length(); i++) {
-        if (!Pep::symbolTable.contains(Asm::listOfReferencedSymbols[i])) {
-            errorString = ";ERROR: Symbol " + Asm::listOfReferencedSymbols[i] + " is used but not defined.";
-            appendMessageInSourceCodePaneAt(Asm::listOfReferencedSymbolLineNums[i], errorString);
-            return false;
-        }
-    }
+    crossReferences = Pep::crossReferenceIndex();
+    referenceSelections.clear();
     Pep::traceTagWarning = false;
     for (int i = 0; i < codeList.size(); i++) {
         if (!codeList[i]->processFormatTraceTags(lineNum, errorString)) {
@@ -142,7 +140,10 @@ QStringList SourceCodePane::getAssemblerListingList()
     assemblerListingList.clear();
     listingTraceList.clear();
     hasCheckBox.clear();
+    listingRowOfLine.clear();
     for (int i = 0; i < codeList.length(); i++) {
+        // Every source line up to .END has a code object, so code i is on line i.
+        listingRowOfLine.append(assemblerListingList.size());
         codeList[i]->appendSourceLine(assemblerListingList, listingTraceList, hasCheckBox);
     }
     return assemblerListingList;
@@ -153,91 +154,110 @@ QStringList SourceCodePane::getListingTraceList()
     return listingTraceList;
 }
 
+QList<int> SourceCodePane::getListingRowOfLine()
+{
+    return listingRowOfLine;
+}
+
 QList<bool> SourceCodePane::getHasCheckBox()
 {
     return hasCheckBox;
 }
 
-void SourceCodePane::adjustCodeList(int addressDelta)
+void SourceCodePane::getRelocations(QList<int> &relocationOffsets, QStringList &relocationSymbols)
 {
+    relocationOffsets.clear();
+    relocationSymbols.clear();
+    int address;
+    QString symbol;
     for (int i = 0; i < codeList.length(); i++) {
-        codeList[i]->adjustMemAddress(addressDelta);
+        if (codeList[i]->getSymbolOperand(address, symbol)) {
+            relocationOffsets.append(address);
+            relocationSymbols.append(symbol);
+        }
     }
 }
 
+void SourceCodePane::getCostAnnotations(QMap<int, QString> &annotationOfAddress, QStringList &summaryList)
+{
+    FlowGraph::annotate(codeList, annotationOfAddress, summaryList);
+}
+
 void SourceCodePane::installOS()
 {
-    for (int i = 0; i < 65536; i++) {
-        Sim::Mem[i] = 0;
-    }
-    int j = Pep::romStartAddress;
+    Sim::Mem.fill(0);
+    int *rom = Sim::Mem.data() + Pep::romStartAddress;
     for (int i = 0; i < objectCode.size(); i++) {
-        Sim::Mem[j++] = objectCode[i];
+        rom[i] = objectCode.at(i);
+    }
+}
+
+QString SourceCodePane::defaultOsCacheFileName(const QString &sourceCode)
+{
+    // The image depends on the source and on the mnemonics it was assembled with.
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(sourceCode.toUtf8());
+    QMapIterator<Enu::EMnemonic, QString> i(Pep::enumToMnemonMap);
+    while (i.hasNext()) {
+        i.next();
+        hash.addData(QString("%1 %2 %3\n").arg(i.key()).arg(i.value()).arg(Pep::addrModesMap.value(i.key())).toUtf8());
+    }
+    QString cacheDir = QDesktopServices::storageLocation(QDesktopServices::CacheLocation);
+    if (cacheDir.isEmpty()) {
+        cacheDir = QDir::tempPath();
     }
+    return QString("%1/pep8os-%2-v%3.pepobj").arg(cacheDir).arg(QString(hash.result().toHex())).arg(ObjectFile::version);
 }
 
-bool SourceCodePane::installDefaultOs()
+bool SourceCodePane::installDefaultOs(QStringList &osListingList, QList<bool> &osHasCheckBox)
 {
-    QString sourceLine;
     QString errorString;
     QStringList sourceCodeList;
-    Code *code;
     int lineNum = 0;
-    bool dotEndDetected = false;
 
     Asm::listOfReferencedSymbols.clear();
+    Asm::listOfReferencedSymbolLineNums.clear();
     Pep::memAddrssToAssemblerListing->clear();
-    Pep::symbolTable.clear();
-    Pep::adjustSymbolValueForBurn.clear();
-    while (!codeList.isEmpty()) {
-        delete codeList.takeFirst();
-    }
+    Pep::clearSymbolTable();
+    codeList.clear();
     QString sourceCode = Pep::resToString(":/help/figures/pep8os.pep");
-    sourceCodeList = sourceCode.split('\n');
-    Pep::byteCount = 0;
-    Pep::burnCount = 0;
-    while (lineNum < sourceCodeList.size() && !dotEndDetected) {
-        sourceLine = sourceCodeList[lineNum];
-        if (!Asm::processSourceLine(sourceLine, lineNum, code, errorString, dotEndDetected)) {
-            return false;
-        }
-        codeList.append(code);
-        lineNum++;
-    }
-    if (!dotEndDetected) {
-        return false;
-    }
-    if (Pep::byteCount > 65535) {
-        return false;
-    }
-    for (int i = 0; i < Asm::listOfReferencedSymbols.length(); i++) {
-        if (!Pep::symbolTable.contains(Asm::listOfReferencedSymbols[i])) {
-            return false;
-        }
-    }
 
-    if (Pep::burnCount != 1) {
-        return false;
+    // Install the image cached by an earlier assembly of the same source if there is one.
+    QString cacheFileName = defaultOsCacheFileName(sourceCode);
+    if (QFile::exists(cacheFileName)
+        && ObjectFile::read(cacheFileName, objectCode, Pep::romStartAddress, osListingList, osHasCheckBox,
+                            *Pep::memAddrssToAssemblerListing, errorString)) {
+        Pep::dotBurnArgument = Pep::romStartAddress + objectCode.size() - 1;
+        Pep::burnCount = 1;
+        installOS();
+        return true;
     }
 
-    // Adjust for .BURN
-    int addressDelta = Pep::dotBurnArgument - Pep::byteCount + 1;
-    QMutableMapIterator <QString, int> i(Pep::symbolTable);
-    while (i.hasNext()) {
-        i.next();
-        if (Pep::adjustSymbolValueForBurn.value(i.key())) {
-            i.setValue(i.value() + addressDelta);
-        }
+    sourceCodeList = sourceCode.split('\n');
+    if (!Asm::assembleProgram(sourceCodeList, osParsedLines, codeList, Enu::EOperatingSystem, objectCode,
+                              lineNum, errorString)) {
+        return false;
     }
-
-    adjustCodeList(addressDelta);
-    Pep::romStartAddress += addressDelta;
-    getObjectCode();
     installOS();
+    osListingList = getAssemblerListingList();
+    osHasCheckBox = hasCheckBox;
+
+    // A failure to cache only costs the next startup an assembly.
+    QDir().mkpath(QFileInfo(cacheFileName).path());
+    ObjectFile::write(cacheFileName, objectCode, Pep::romStartAddress, osListingList, osHasCheckBox,
+                      *Pep::memAddrssToAssemblerListing, false, errorString);
 
     return true;
 }
 
+void SourceCodePane::clearParsedLines()
+{
+    codeList.clear();
+    Asm::clearParsedLines(parsedLines);
+    Asm::clearParsedLines(osParsedLines);
+    Asm::clearParsedLines(backgroundParsedLines);
+}
+
 void SourceCodePane::removeErrorMessages()
 {
     QTextCursor cursor(ui->textEdit->document()->find(";ERROR:"));
@@ -400,6 +420,139 @@ void SourceCodePane::tab()
     }
 }
 
+void SourceCodePane::setBackgroundAssemblyEnabled(bool enabled)
+{
+    backgroundAssemblyEnabled = enabled;
+    if (enabled) {
+        // The mnemonics may have changed, so the source is checked again even if it has not.
+        checkedSourceCode = "";
+        scheduleBackgroundAssembly();
+    }
+    else {
+        backgroundTimer->stop();
+        backgroundWatcher.waitForFinished();
+        if (backgroundJob != NULL) {
+            Asm::clearParsedLines(backgroundJob->parsedLines);
+            delete backgroundJob;
+            backgroundJob = NULL;
+        }
+        Asm::clearParsedLines(backgroundParsedLines);
+    }
+}
+
+void SourceCodePane::runBackgroundJob(BackgroundJob *job)
+{
+    Asm::checkSourceLines(job->sourceCodeList, job->parsedLines, job->errorOfLine, job->crossReferences);
+}
+
+void SourceCodePane::showDiagnostics(const QMap<int, QString> &errorOfLine)
+{
+    diagnosticSelections.clear();
+    QMapIterator<int, QString> i(errorOfLine);
+    while (i.hasNext()) {
+        i.next();
+        QTextBlock block = ui->textEdit->document()->findBlockByNumber(i.key());
+        if (!block.isValid()) {
+            continue;
+        }
+        QTextEdit::ExtraSelection selection;
+        selection.cursor = QTextCursor(block);
+        selection.format.setBackground(QColor(255, 220, 220));
+        selection.format.setProperty(QTextFormat::FullWidthSelection, true);
+        selection.format.setToolTip(i.value().mid(1)); // Without the semicolon
+        diagnosticSelections.append(selection);
+    }
+    updateExtraSelections();
+}
+
+void SourceCodePane::updateExtraSelections()
+{
+    ui->textEdit->setExtraSelections(referenceSelections + diagnosticSelections);
+}
+
+void SourceCodePane::moveCursorToLine(int lineNum)
+{
+    QTextBlock block = ui->textEdit->document()->findBlockByNumber(lineNum);
+    if (block.isValid()) {
+        ui->textEdit->setTextCursor(QTextCursor(block));
+        ui->textEdit->ensureCursorVisible();
+    }
+}
+
+bool SourceCodePane::goToDefinition(QString &symbol)
+{
+    QTextCursor cursor = ui->textEdit->textCursor();
+    symbol = Asm::identifierAt(cursor.block().text(), cursor.positionInBlock());
+    if (!crossReferences.contains(symbol) || crossReferences.value(symbol).definitionLineNum < 0) {
+        return false;
+    }
+    moveCursorToLine(crossReferences.value(symbol).definitionLineNum);
+    return true;
+}
+
+int SourceCodePane::findReferences(QString &symbol)
+{
+    QTextCursor cursor = ui->textEdit->textCursor();
+    symbol = Asm::identifierAt(cursor.block().text(), cursor.positionInBlock());
+    referenceSelections.clear();
+    if (!crossReferences.contains(symbol)) {
+        updateExtraSelections();
+        return -1;
+    }
+    const Pep::CrossReference &crossReference = crossReferences[symbol];
+    QList<int> lineNums = crossReference.referenceLineNums;
+    if (crossReference.definitionLineNum >= 0) {
+        lineNums.append(crossReference.definitionLineNum);
+    }
+    qSort(lineNums);
+    int nextLineNum = -1;
+    for (int i = 0; i < lineNums.size(); i++) {
+        QTextBlock block = ui->textEdit->document()->findBlockByNumber(lineNums.at(i));
+        if (!block.isValid()) {
+            continue;
+        }
+        QTextEdit::ExtraSelection selection;
+        selection.cursor = QTextCursor(block);
+        selection.format.setBackground(QColor(255, 255, 200));
+        selection.format.setProperty(QTextFormat::FullWidthSelection, true);
+        referenceSelections.append(selection);
+        if (nextLineNum < 0 && lineNums.at(i) > cursor.blockNumber()) {
+            nextLineNum = lineNums.at(i);
+        }
+    }
+    updateExtraSelections();
+    if (nextLineNum < 0 && !lineNums.isEmpty()) {
+        nextLineNum = lineNums.first(); // Wrap around to the first line.
+    }
+    if (nextLineNum >= 0) {
+        moveCursorToLine(nextLineNum);
+    }
+    return crossReference.referenceLineNums.size();
+}
+
+Pep::CrossReferenceIndex SourceCodePane::getCrossReferenceIndex()
+{
+    return crossReferences;
+}
+
+bool SourceCodePane::eventFilter(QObject *object, QEvent *event)
+{
+    if (object == ui->textEdit->viewport() && event->type() == QEvent::ToolTip) {
+        // The cursors of the selections follow the edits, so the message stays on its line.
+        QHelpEvent *helpEvent = static_cast<QHelpEvent *>(event);
+        int blockNumber = ui->textEdit->cursorForPosition(helpEvent->pos()).blockNumber();
+        foreach (const QTextEdit::ExtraSelection &selection, diagnosticSelections) {
+            if (selection.cursor.blockNumber() == blockNumber) {
+                QToolTip::showText(helpEvent->globalPos(), selection.format.toolTip());
+                return true;
+            }
+        }
+        QToolTip::hideText();
+        return true;
+    }
+    return QWidget::eventFilter(object, event);
+}
+
 void SourceCodePane::mouseReleaseEvent(QMouseEvent *)
 {
     ui->textEdit->setFocus();
@@ -423,3 +576,48 @@ void SourceCodePane::setLabelToModified(bool modified)
 }
 
 
+
+void SourceCodePane::scheduleBackgroundAssembly()
+{
+    if (backgroundAssemblyEnabled) {
+        backgroundTimer->start();
+    }
+}
+
+void SourceCodePane::startBackgroundAssembly()
+{
+    // One check at a time. A check that finishes on a stale snapshot starts the next one.
+    if (!backgroundAssemblyEnabled || backgroundJob != NULL) {
+        return;
+    }
+    QString sourceCode = ui->textEdit->toPlainText();
+    if (sourceCode == checkedSourceCode) {
+        return; // Only the formats changed, or the edits were undone.
+    }
+    checkedSourceCode = sourceCode;
+    backgroundJob = new BackgroundJob;
+    backgroundJob->sourceCode = sourceCode;
+    backgroundJob->sourceCodeList = sourceCode.split('\n');
+    backgroundWatcher.setFuture(QtConcurrent::run(&SourceCodePane::runBackgroundJob, backgroundJob));
+}
+
+void SourceCodePane::backgroundAssemblyFinished()
+{
+    // The job is NULL if it was discarded by setBackgroundAssemblyEnabled.
+    if (backgroundJob == NULL) {
+        return;
+    }
+    BackgroundJob *job = backgroundJob;
+    backgroundJob = NULL;
+    Asm::clearParsedLines(backgroundParsedLines);
+    backgroundParsedLines = job->parsedLines;
+    if (ui->textEdit->toPlainText() == job->sourceCode) {
+        crossReferences = job->crossReferences;
+        referenceSelections.clear();
+        showDiagnostics(job->errorOfLine);
+    }
+    else if (!backgroundTimer->isActive()) {
+        startBackgroundAssembly();
+    }
+    delete job;
+}
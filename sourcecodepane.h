@@ -25,10 +25,16 @@
 #include <QtGui/QWidget>
 #include <QString>
 #include <QList>
+#include <QFutureWatcher>
+#include <QTextEdit>
 #include "asm.h" // For Code in QList<Code *> codeList;
 #include "pephighlighter.h" // For syntax highlighting
 #include "enu.h"
 
+QT_BEGIN_NAMESPACE
+class QTimer;
+QT_END_NAMESPACE
+
 namespace Ui {
     class SourceCodePane;
 }
@@ -40,11 +46,13 @@ public:
     explicit SourceCodePane(QWidget *parent = 0);
     virtual ~SourceCodePane();
 
-    bool assemble();
+    bool assemble(Enu::EAssembly assembly = Enu::EProgram);
     // Pre: The source code pane contains a Pep/8 source program.
-    // Post: If the program assembles correctly, true is returned, and codeList is populated
-    // with the code objects. Otherwise false is returned and codeList is partially populated.
-    // Post: Pep::symbolTable is populated with values not adjusted for .BURN.
+    // Pre: The parse of the latest background check, if any, is reused for the unchanged lines.
+    // Post: The program is assembled by Asm::assembleProgram as the given kind of assembly.
+    // If it assembles correctly, true is returned, and codeList is populated with the code objects.
+    // Otherwise false is returned, the error is shown in the pane and codeList is partially populated.
+    // Post: Pep::symbols is populated, with values adjusted for .BURN in an OS.
     // Post: Pep::byteCount is the byte count for the object code not adjusted for .BURN.
     // Post: Pep::burnCount is the number of .BURN instructions encountered in the source program.
 
@@ -67,18 +75,35 @@ public:
     // Pre: hasCheckBox is populated.
     // Post: hasCheckBox is returned.
 
-    void adjustCodeList(int addressDelta);
+    QList<int> getListingRowOfLine();
+    // Pre: assemblerListingList is populated.
+    // Post: Returns, for each source line up to and including .END, the row of assemblerListingList
+    // at which its listing starts.
+
+    void getRelocations(QList<int> &relocationOffsets, QStringList &relocationSymbols);
+    // Pre: codeList is populated with code from a module assembled at address 0.
+    // Post: relocationOffsets and relocationSymbols hold, for each word of object code that
+    // holds the value of a symbol, its offset and the symbol.
+
+    void getCostAnnotations(QMap<int, QString> &annotationOfAddress, QStringList &summaryList);
     // Pre: codeList is populated with code from a complete correct Pep/8 source program.
-    // Post: The memAddress field of each code object is incremented by addressDelta.
+    // Post: annotationOfAddress and summaryList hold the static cost annotations of the flow
+    // graph of the program.
 
     void installOS();
     // Pre: objectCode is populated with code from a complete correct Pep/8 OS source program.
     // Post: objectCode is loaded into OS rom of Pep::Mem.
 
-    bool installDefaultOs();
-    // Post: the pep/8 operating system is installed into memory, and true is returned
+    bool installDefaultOs(QStringList &osListingList, QList<bool> &osHasCheckBox);
+    // Post: the pep/8 operating system is installed into memory, osListingList and osHasCheckBox
+    // are its assembler listing and break point list, and true is returned
+    // Post: The image is read from the cache if the default OS source has been assembled before
+    // with the same mnemonics, otherwise it is assembled and cached
     // If assembly fails, false is returned
-    // This function should only be called on program startup once
+
+    void clearParsedLines();
+    // Post: The parse caches are emptied and codeList, whose code objects they own, is cleared,
+    // so that the next assembly parses every line with the current mnemonic and symbol tables.
 
     void removeErrorMessages();
     // Post: Searces for the string ";ERROR: " on each line and removes the end of the line.
@@ -140,22 +165,87 @@ public:
 
     void tab();
 
+    bool goToDefinition(QString &symbol);
+    // Post: symbol is the identifier at the cursor. If the cross-reference index has its definition,
+    // the cursor is moved to it and true is returned.
+
+    int findReferences(QString &symbol);
+    // Post: symbol is the identifier at the cursor. If it is in the cross-reference index, the
+    // lines that define and use it are highlighted, the cursor is moved to the next of them after
+    // the cursor line, and the number of lines that use it is returned. Otherwise -1 is returned.
+
+    Pep::CrossReferenceIndex getCrossReferenceIndex();
+    // Post: Returns the cross-reference index of the source, from the last background check or
+    // assembly of the current text.
+
+    void setBackgroundAssemblyEnabled(bool enabled);
+    // Post: If enabled, the source is checked in the background shortly after each edit.
+    // Post: If not enabled, a running check is waited for and its result is discarded, so that
+    // the mnemonic tables can be changed safely.
+
 private:
     Ui::SourceCodePane *ui;
-    QList<Code *> codeList;
+    QList<Code *> codeList; // Code objects are owned by parsedLines or osParsedLines.
+    QVector<Asm::ParsedLine> parsedLines; // Parse cache of the last assembled source program
+    QVector<Asm::ParsedLine> osParsedLines; // Parse cache of the default OS
     QList<int> objectCode;
     QStringList assemblerListingList;
     QStringList listingTraceList;
     QList<bool> hasCheckBox;
+    QList<int> listingRowOfLine;
+    Pep::CrossReferenceIndex crossReferences;
 
     PepHighlighter *pepHighlighter;
 
+    // Background assembly
+    // A check parses a snapshot of the source on a worker thread, with no global state, and
+    // collects all of its errors. They are shown as tinted lines with the message as the
+    // tool tip, without changing the text. The parse of the latest check is kept for assemble.
+    struct BackgroundJob
+    {
+        QString sourceCode;
+        QStringList sourceCodeList;
+        QVector<Asm::ParsedLine> parsedLines;
+        QMap<int, QString> errorOfLine;
+        Pep::CrossReferenceIndex crossReferences;
+    };
+    static const int backgroundDelay = 500; // Milliseconds without edits before a check starts
+    QTimer *backgroundTimer;
+    QFutureWatcher<void> backgroundWatcher;
+    BackgroundJob *backgroundJob; // The running check, or NULL
+    QString checkedSourceCode; // Source of the last check started
+    QVector<Asm::ParsedLine> backgroundParsedLines; // Parse of the latest finished check
+    bool backgroundAssemblyEnabled;
+
+    static void runBackgroundJob(BackgroundJob *job);
+    // Post: job->parsedLines, job->errorOfLine and job->crossReferences are set by Asm::checkSourceLines.
+
+    QList<QTextEdit::ExtraSelection> diagnosticSelections;
+    QList<QTextEdit::ExtraSelection> referenceSelections;
+
+    void showDiagnostics(const QMap<int, QString> &errorOfLine);
+    // Post: The lines in errorOfLine are tinted with their messages as tool tips.
+
+    void updateExtraSelections();
+    // Post: The diagnostics and the references are shown in the text edit.
+
+    void moveCursorToLine(int lineNum);
+    // Post: The cursor is at the start of line lineNum, which is made visible.
+
+    bool eventFilter(QObject *object, QEvent *event);
+
+    QString defaultOsCacheFileName(const QString &sourceCode);
+    // Post: The name of the cache file for the default OS assembled from sourceCode is returned.
+
     void mouseReleaseEvent(QMouseEvent *);
 
     void mouseDoubleClickEvent(QMouseEvent *);
 
 private slots:
     void setLabelToModified(bool modified);
+    void scheduleBackgroundAssembly();
+    void startBackgroundAssembly();
+    void backgroundAssemblyFinished();
 
 signals:
     void undoAvailable(bool);